@@ -23,23 +23,14 @@ Rectangle {
     Dialog {
         id: info
         anchors.centerIn: parent
-        visible: true
-        dialogText: "Scanning for characteristics..."
+        visible: characteristicview.count === 0
+        dialogText: Device.discovering ? "Scanning for characteristics..."
+                                       : "No characteristic found"
+        busyImage: Device.discovering
     }
 
     Connections {
         target: Device
-        function onCharacteristicsUpdated() {
-            menu.menuText = "Back"
-            if (characteristicview.count === 0) {
-                info.dialogText = "No characteristic found"
-                info.busyImage = false
-            } else {
-                info.visible = false
-                info.busyImage = true
-            }
-        }
-
         function onDisconnected() {
             characteristicsPage.showDevices()
         }
@@ -55,7 +46,10 @@ Rectangle {
         model: Device.characteristicList
 
         delegate: Rectangle {
-            required property var modelData
+            required property string characteristicName
+            required property string characteristicUuid
+            required property string characteristicValue
+            required property string characteristicPermission
             id: box
             height: 300
             width: characteristicview.width
@@ -66,7 +60,7 @@ Rectangle {
 
             Label {
                 id: characteristicName
-                textContent: box.modelData.characteristicName
+                textContent: box.characteristicName
                 anchors.top: parent.top
                 anchors.topMargin: 5
             }
@@ -74,7 +68,7 @@ Rectangle {
             Label {
                 id: characteristicUuid
                 font.pointSize: characteristicName.font.pointSize * 0.7
-                textContent: box.modelData.characteristicUuid
+                textContent: box.characteristicUuid
                 anchors.top: characteristicName.bottom
                 anchors.topMargin: 5
             }
@@ -82,24 +76,16 @@ Rectangle {
             Label {
                 id: characteristicValue
                 font.pointSize: characteristicName.font.pointSize * 0.7
-                textContent: ("Value: " + box.modelData.characteristicValue)
-                anchors.bottom: characteristicHandle.top
-                horizontalAlignment: Text.AlignHCenter
-                anchors.topMargin: 5
-            }
-
-            Label {
-                id: characteristicHandle
-                font.pointSize: characteristicName.font.pointSize * 0.7
-                textContent: ("Handlers: " + box.modelData.characteristicHandle)
+                textContent: ("Value: " + box.characteristicValue)
                 anchors.bottom: characteristicPermission.top
+                horizontalAlignment: Text.AlignHCenter
                 anchors.topMargin: 5
             }
 
             Label {
                 id: characteristicPermission
                 font.pointSize: characteristicName.font.pointSize * 0.7
-                textContent: box.modelData.characteristicPermission
+                textContent: box.characteristicPermission
                 anchors.bottom: parent.bottom
                 anchors.topMargin: 5
                 anchors.bottomMargin: 5
@@ -111,7 +97,7 @@ Rectangle {
         id: menu
         anchors.bottom: parent.bottom
         menuWidth: parent.width
-        menuText: Device.update
+        menuText: Device.discovering ? Device.update : "Back"
         menuHeight: (parent.height / 6)
         onButtonClick: {
             characteristicsPage.showServices()
@@ -18,6 +18,27 @@ Rectangle {
         }
     }
 
+    ClickableLabel {
+        id: mixer
+        readonly property var names : [qsTr("Direct"), qsTr("Elevon"), qsTr("V-Tail"),
+                                        qsTr("Flaperon"), qsTr("Differential Thrust")]
+        text : qsTr("Mixer: %1").arg(Device.controller.mixerPreset < names.length
+                                      ? names[Device.controller.mixerPreset] : qsTr("Custom"))
+        anchors.top : showTrims.bottom
+        anchors.topMargin : implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+
+        onClicked : {
+            // presets that mix into AUX channels are refused in the raw format
+            var next = (Device.controller.mixerPreset + 1) % names.length
+            Device.controller.mixerPreset = next
+            while (Device.controller.mixerPreset !== next) {
+                next = (next + 1) % names.length
+                Device.controller.mixerPreset = next
+            }
+        }
+    }
+
     ClickableLabel {
         id: selectDevice
         text :  qsTr("Select Device")
@@ -33,7 +54,9 @@ Rectangle {
 
     ClickableLabel {
         id: disconnecDevice
-        text :  (Device.rxTxConnected ? qsTr("Disconnect ") : qsTr("Reconnect ")) + Device.connectedDeviceName
+        text :  (Device.rxTxConnected ? qsTr("Disconnect ")
+                 : Device.connectionState === Device.Disconnected ? qsTr("Reconnect ")
+                 : qsTr("Reconnecting ")) + Device.connectedDeviceName
         anchors.top : parent.top
         anchors.topMargin : implicitHeight/2
         anchors.right : parent.right
@@ -41,14 +64,147 @@ Rectangle {
         visible : Device.connectedDeviceName.length != 0
         textColor : Device.rxTxConnected ? "green" : "black"
         onClicked : {
-            if (Device.rxTxConnected) {
+            if (Device.connectionState !== Device.Disconnected) {
                 Device.disconnectFromDevice()
             } else {
-                Device.scanServices(Device.connectDeviceId)
+                Device.scanServices(Device.connectedDeviceId)
             }
         }
     }
 
+    Column {
+        id: vehicles
+        anchors.top : selectDevice.bottom
+        anchors.topMargin : selectDevice.implicitHeight/4
+        anchors.left : parent.left
+        anchors.leftMargin : parent.width * 0.02
+        // only worth showing once a second vehicle is connected
+        visible : Device.vehicles.count > 1
+        Repeater {
+            model : Device.vehicles.links
+            delegate : ClickableLabel {
+                required property var modelData
+                text : qsTr("%1  %2 fps  radio p50 %3  p99 %4 ms")
+                           .arg(modelData.primary ? Device.connectedDeviceName : modelData.name)
+                           .arg(modelData.frameRate.toFixed(0))
+                           .arg(modelData.radioLatencyP50.toFixed(1))
+                           .arg(modelData.radioLatencyP99.toFixed(1))
+                textColor : modelData.ready ? "green" : "black"
+                // the primary vehicle is disconnected from the top right
+                onClicked : Device.vehicles.removeLink(modelData)
+            }
+        }
+    }
+
+    ClickableLabel {
+        id: filter
+        readonly property var names : [qsTr("Off"), qsTr("Light"), qsTr("Smooth")]
+        text : qsTr("Filter: %1").arg(Device.controller.filterPreset < names.length
+                                       ? names[Device.controller.filterPreset] : qsTr("Custom"))
+        anchors.top : mixer.bottom
+        anchors.topMargin : implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+
+        onClicked : {
+            Device.controller.filterPreset = (Device.controller.filterPreset + 1) % names.length
+        }
+    }
+
+    ClickableLabel {
+        id: frameFormat
+        readonly property var names : [qsTr("Raw"), qsTr("V1"), qsTr("V1 Packed")]
+        text : Device.controller.frameFormat !== 2
+               ? qsTr("Format: %1").arg(names[Device.controller.frameFormat])
+               : Device.controller.effectiveResolution > 0
+                 ? qsTr("Format: %1, %2 bit").arg(names[2]).arg(Device.controller.effectiveResolution)
+                 : qsTr("Format: %1, does not fit the MTU").arg(names[2])
+        anchors.top : filter.bottom
+        anchors.topMargin : implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+
+        onClicked : {
+            Device.controller.frameFormat = (Device.controller.frameFormat + 1) % names.length
+        }
+    }
+
+    Text {
+        id: telemetry
+        anchors.top : frameFormat.bottom
+        anchors.topMargin : frameFormat.implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+        visible : Device.telemetry.available
+        text : qsTr("%1 V  %2%  RSSI %3 dBm").arg(Device.telemetry.batteryVoltage.toFixed(2))
+                                             .arg(Device.telemetry.batteryRemaining)
+                                             .arg(Device.telemetry.rssi)
+    }
+
+    ClickableLabel {
+        id: gamepad
+        property bool unavailable : false
+        anchors.top : telemetry.bottom
+        anchors.topMargin : implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+        text : !Device.gamepad.active
+               ? (unavailable ? qsTr("Gamepad: not supported") : qsTr("Gamepad: Off"))
+               : Device.gamepad.devices.length > 0
+                 ? qsTr("Gamepad: %1").arg(Device.gamepad.devices.join(", "))
+                 : qsTr("Gamepad: waiting for a device")
+        onClicked : {
+            if (Device.gamepad.active)
+                Device.gamepad.stop()
+            else
+                unavailable = !Device.gamepad.start()
+        }
+    }
+
+    Text {
+        id: linkParameters
+        anchors.bottom : latency.top
+        anchors.horizontalCenter: parent.horizontalCenter
+        visible : Device.rxTxConnected && Device.connectionInterval > 0
+        text : qsTr("Interval %1 ms  latency %2  timeout %3 ms  frame %4 ms")
+                   .arg(Device.connectionInterval.toFixed(2))
+                   .arg(Device.peripheralLatency)
+                   .arg(Device.supervisionTimeout)
+                   .arg((Device.controller.scheduler.effectiveFrameInterval / 1000).toFixed(2))
+    }
+
+    ClickableLabel {
+        id: connectionProfile
+        readonly property var names : [qsTr("Central default"), qsTr("Low latency"), qsTr("Balanced")]
+        text : qsTr("Link: %1%2").arg(names[Device.connectionProfile])
+                                 .arg(Device.connectionProfilePending ? qsTr(" (after reconnect)") : "")
+        anchors.bottom : linkParameters.top
+        anchors.bottomMargin : implicitHeight/4
+        anchors.horizontalCenter: parent.horizontalCenter
+        visible : Device.rxTxConnected
+        onClicked : {
+            Device.connectionProfile = (Device.connectionProfile + 1) % names.length
+        }
+    }
+
+    ClickableLabel {
+        id: latency
+        text : Device.latencyProbe.enabled
+               ? qsTr("RTT p50 %1  p99 %2  p99.9 %3  max %4 ms")
+                     .arg(Device.latencyProbe.p50.toFixed(1))
+                     .arg(Device.latencyProbe.p99.toFixed(1))
+                     .arg(Device.latencyProbe.p999.toFixed(1))
+                     .arg(Device.latencyProbe.max.toFixed(1))
+               : Device.latencyProbe.available
+               ? qsTr("Measure Latency")
+               : qsTr("Latency needs a protocol frame format")
+        textColor : Device.latencyProbe.available ? "black" : "gray"
+        anchors.bottom : parent.bottom
+        anchors.bottomMargin : implicitHeight/2
+        anchors.horizontalCenter: parent.horizontalCenter
+        visible : Device.rxTxConnected
+        onClicked : {
+            if (Device.latencyProbe.available)
+                Device.latencyProbe.enabled = !Device.latencyProbe.enabled
+        }
+    }
+
     Item{
         enabled : Device.rxTxConnected
         anchors.fill: parent
@@ -58,13 +214,8 @@ Rectangle {
             height : root.joystickDim
             anchors.left : parent.left
             anchors.bottom: parent.bottom
-        }
-
-        Connections {
-            target: joystickLeft
-            function onJoystickMoved(x, y) {
-                Device.controller.leftStickMoved(x,y)
-            }
+            controller : Device.controller
+            stick : JoyStickArea.LeftStick
         }
 
         JoyStick {
@@ -75,13 +226,8 @@ Rectangle {
             height : root.joystickDim
             anchors.right: parent.right
             anchors.bottom: parent.bottom
-        }
-
-        Connections {
-            target: joystickRight
-            function onJoystickMoved(x, y) {
-                Device.controller.rightStickMoved(x,y)
-            }
+            controller : Device.controller
+            stick : JoyStickArea.RightStick
         }
     }
 }
@@ -40,8 +40,8 @@ Rectangle {
             if (Device.state)
                 return "Discovering"
 
-            if (Device.devicesList.length > 0)
-                return "Select a device"
+            if (Device.devicesList.count > 0)
+                return "Select a device, hold to add a vehicle"
 
             return "Start Discovery"
         }
@@ -63,7 +63,8 @@ Rectangle {
         model: Device.devicesList
 
         delegate: Rectangle {
-            required property var modelData
+            required property string deviceName
+            required property string deviceAddress
             id: box
             height: 50
             width: theListView.width
@@ -75,21 +76,23 @@ Rectangle {
             MouseArea {
                 anchors.fill: parent
                 onClicked: {
-                    Device.scanServices(box.modelData.deviceAddress)
+                    Device.scanServices(box.deviceAddress)
                     // showServices()
                 }
+                // flown next to the primary vehicle, see Device.vehicles
+                onPressAndHold: Device.addVehicle(box.deviceAddress)
             }
 
             Label {
                 id: deviceName
-                textContent: box.modelData.deviceName
+                textContent: box.deviceName
                 anchors.top: parent.top
                 anchors.topMargin: 5
             }
 
             Label {
                 id: deviceAddress
-                textContent: box.modelData.deviceAddress
+                textContent: box.deviceAddress
                 font.pointSize: deviceName.font.pointSize * 0.7
                 anchors.bottom: box.bottom
                 anchors.bottomMargin: 5
@@ -16,18 +16,14 @@ Item {
     property bool showVerticalTrimOnLeft : false
 
 
+    // set to feed the stick values straight into a ControllerObject
+    property alias controller : area.controller
+    property alias stick : area.stick
+
     signal joystickMoved(double x, double y);
     readonly property double minDimension : height < width ? height : width
     property double trimStep : 0.01
 
-    onHorizontalTrimChanged : {
-        joystick.updateMove()
-    }
-
-    onVerticalTrimChanged : {
-        joystick.updateMove()
-    }
-
     Rectangle {
         id: joystick
 
@@ -35,105 +31,19 @@ Item {
         height : width
         radius : height / 2
         color: "gray"
-        property real angle : 0
-        property real distance : 0
 
         anchors.centerIn: parent
 
-        ParallelAnimation {
-            id: returnAnimation
-            NumberAnimation { target: thumb.anchors; property: "horizontalCenterOffset";
-                to: 0; duration: 200; easing.type: Easing.OutSine }
-            NumberAnimation { target: thumb.anchors; property: "verticalCenterOffset";
-                to: 0; duration: 200; easing.type: Easing.OutSine }
-
-        }
-
-        function updateMove() {
-            mouse.posChanged()
-        }
-
-        MultiPointTouchArea  {
-            id: mouse
-            touchPoints: [
-                TouchPoint { id: point1 }
-            ]
-            property real mouseX2 : root.verticalOnly ? width * 0.5 : point1.x
-            property real mouseY2 : root.horizontalOnly ? height * 0.5 : point1.y
-
-            property real fingerAngle : Math.atan2(mouseX2, mouseY2)
-            property int mcx : mouseX2 - width * 0.5
-            property int mcy : mouseY2 - height * 0.5
-            property bool fingerInBounds : fingerDistance2 < distanceBound2
-            property real fingerDistance2 : mcx * mcx + mcy * mcy
-            property real distanceBound : width * 0.5 - thumb.width * 0.5
-            property real distanceBound2 : distanceBound * distanceBound
-
-            property double signal_x : (mouseX2 - joystick.width/2) / distanceBound
-            property double signal_y : -(mouseY2 - joystick.height/2) / distanceBound
-
-            property double xMovement : 0
-            property double yMovement : 0
-
+        JoyStickArea {
+            id: area
             anchors.fill: parent
-
-            onPressed: {
-                returnAnimation.stop();
-            }
-
-            onReleased: {
-                returnAnimation.restart()
-                // console.log("RESTART")
-            }
-
-            onUpdated: {
-                if (fingerInBounds) {
-                    thumb.anchors.horizontalCenterOffset = mcx
-                    thumb.anchors.verticalCenterOffset = mcy
-                } else {
-                    var angle = Math.atan2(mcy, mcx)
-                    thumb.anchors.horizontalCenterOffset = Math.cos(angle) * distanceBound
-                    thumb.anchors.verticalCenterOffset = Math.sin(angle) * distanceBound
-                }
-
-                angle = Math.atan2(signal_y, signal_x)
-
-                if(fingerInBounds) {
-                    xMovement = root.verticalOnly ? 0 : Math.cos(angle) * Math.sqrt(fingerDistance2) / distanceBound
-                    yMovement = root.horizontalOnly ? 0 : Math.sin(angle) * Math.sqrt(fingerDistance2) / distanceBound
-                } else {
-                    xMovement = root.verticalOnly ? 0 : Math.cos(angle) * 1
-                    yMovement = root.horizontalOnly ? 0 : Math.sin(angle) * 1
-                }
-
-                posChanged()
-            }
-
-            function onUpdateThumb() {
-                let xThumbPos = thumb.anchors.horizontalCenterOffset
-                let yThumbPos = -thumb.anchors.verticalCenterOffset
-                let thumbDistance = xThumbPos * xThumbPos + yThumbPos * yThumbPos
-
-                let xThumbPosFactor = thumb.anchors.horizontalCenterOffset / distanceBound
-                let yThumbPosFactor = -thumb.anchors.verticalCenterOffset / distanceBound
-
-                let  angle = Math.atan2(yThumbPosFactor, xThumbPosFactor)
-                // console.log("Angle = ", angle)
-
-                xMovement = root.verticalOnly ? 0 : Math.cos(angle) * Math.sqrt(thumbDistance) / distanceBound
-                yMovement = root.horizontalOnly ? 0 : Math.sin(angle) * Math.sqrt(thumbDistance) / distanceBound
-                posChanged()
-            }
-
-            function clamp(val) {
-                return Math.min(Math.max(val, -1.0), 1.0);
-            }
-
-            function posChanged() {
-                let xVal = xMovement + root.horizontalTrim;
-                let yVal = yMovement + root.verticalTrim;
-                root.joystickMoved(clamp(xVal), clamp(yVal))
-            }
+            verticalOnly: root.verticalOnly
+            horizontalOnly: root.horizontalOnly
+            horizontalTrim: root.horizontalTrim
+            verticalTrim: root.verticalTrim
+            thumbSize: thumb.width
+            // signal to signal, no handler runs per event
+            Component.onCompleted: moved.connect(root.joystickMoved)
         }
 
         Rectangle {
@@ -145,20 +55,8 @@ Item {
 
             color : "black"
             anchors.centerIn: parent
-
-            onXChanged: {
-                updateMovement()
-            }
-
-            onYChanged: {
-                updateMovement()
-            }
-
-            function updateMovement() {
-                if (returnAnimation.running) {
-                    mouse.onUpdateThumb()
-                }
-            }
+            anchors.horizontalCenterOffset: area.thumbX
+            anchors.verticalCenterOffset: area.thumbY
         }
     }
 
@@ -33,19 +33,13 @@ Rectangle {
     Dialog {
         id: info
         anchors.centerIn: parent
-        visible: true
-        dialogText: "Scanning for services..."
+        visible: servicesview.count === 0
+        dialogText: Device.discovering ? "Scanning for services..." : "No services found"
+        busyImage: Device.discovering
     }
 
     Connections {
         target: Device
-        function onServicesUpdated() {
-            if (servicesview.count === 0)
-                info.dialogText = "No services found"
-            else
-                info.visible = false
-        }
-
         function onDisconnected() {
             servicesPage.showDevices()
         }
@@ -60,7 +54,10 @@ Rectangle {
         clip: true
 
         delegate: Rectangle {
-            required property var modelData
+            required property string serviceName
+            required property string serviceUuid
+            required property string serviceType
+            required property bool isRxTx
             id: box
             height: 70
             color: "lightsteelblue"
@@ -74,9 +71,9 @@ Rectangle {
                 anchors.rightMargin : 5
                 anchors.verticalCenter : parent.verticalCenter
 
-                visible : box.modelData.isRxTx
+                visible : box.isRxTx
                 onClicked: {
-                    Device.connectToService(box.modelData.serviceUuid)
+                    Device.connectToService(box.serviceUuid)
                     servicesPage.showCharacteristics()
                 }
                 text : qsTr("Connect")
@@ -84,13 +81,13 @@ Rectangle {
 
             Label {
                 id: serviceName
-                textContent: box.modelData.serviceName
+                textContent: box.serviceName
                 anchors.top: parent.top
                 anchors.topMargin: 5
             }
 
             Label {
-                textContent: box.modelData.serviceType
+                textContent: box.serviceType
                 font.pointSize: serviceName.font.pointSize * 0.5
                 anchors.top: serviceName.bottom
             }
@@ -98,7 +95,7 @@ Rectangle {
             Label {
                 id: serviceUuid
                 font.pointSize: serviceName.font.pointSize * 0.5
-                textContent: box.modelData.serviceUuid
+                textContent: box.serviceUuid
                 anchors.bottom: box.bottom
                 anchors.bottomMargin: 5
             }
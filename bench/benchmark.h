@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+
+#include <latencyhistogram.h>
+
+// Minimal harness for the headless benchmarks. Every case returns its
+// metrics as a JSON object, main() collects them into one document.
+namespace Benchmark {
+
+struct Options
+{
+    // multiplies iteration counts and durations, --quick sets 0.1
+    double scale = 1.0;
+};
+
+using Run = QJsonObject (*)(const Options &options);
+
+struct Case
+{
+    const char *name;
+    Run run;
+};
+
+QList<Case> &registry();
+
+struct Register
+{
+    Register(const char *name, Run run) { registry().append({name, run}); }
+};
+
+// operator new calls since program start, see allocationcounter.cpp
+quint64 allocations();
+
+inline int scaled(const Options &options, int count)
+{
+    return qMax(1, int(count * options.scale));
+}
+
+inline QJsonObject percentiles(const LatencyHistogram &histogram)
+{
+    return {{"count", double(histogram.count())},
+            {"p50_us", double(histogram.percentile(50))},
+            {"p99_us", double(histogram.percentile(99))},
+            {"p999_us", double(histogram.percentile(99.9))},
+            {"max_us", double(histogram.max())}};
+}
+
+} // namespace Benchmark
+
+#endif // BENCHMARK_H
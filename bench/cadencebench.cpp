@@ -0,0 +1,126 @@
+#include "benchmark.h"
+
+#include <QEventLoop>
+#include <QTimer>
+
+#include <controllerobject.h>
+#include <framescheduler.h>
+#include <linkscheduler.h>
+#include <loopbacklinktransport.h>
+#include <vehiclelink.h>
+
+#include <cmath>
+
+using namespace Benchmark;
+
+namespace {
+
+constexpr int connection_interval_ms = 15;
+// touch events arrive at about this rate while a stick is dragged
+constexpr int stick_update_ms = 4;
+
+void runEventLoop(int msec)
+{
+    QEventLoop loop;
+    QTimer::singleShot(msec, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// sticks sweep slowly, like a pilot holding a turn
+QTimer *startStickSweep(ControllerObject *controller, QObject *parent)
+{
+    auto timer = new QTimer(parent);
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(stick_update_ms);
+    QObject::connect(timer, &QTimer::timeout, parent, [controller, step = 0]() mutable {
+        const double phase = ++step * 0.01;
+        controller->leftStickMoved(std::sin(phase), std::cos(phase));
+        controller->rightStickMoved(std::cos(phase), std::sin(phase));
+    });
+    timer->start();
+    return timer;
+}
+
+QJsonObject runLoopback(const Options &options)
+{
+    const int duration = scaled(options, 3000);
+
+    QObject context;
+    ControllerObject controller;
+    LoopbackLinkTransport transport;
+    transport.setConnectionInterval(connection_interval_ms);
+    transport.setEcho(false);
+    QObject::connect(&controller, &ControllerObject::dataUpdated, &transport,
+                     [&transport](const QByteArray &data) { transport.write(data); },
+                     Qt::DirectConnection);
+
+    LatencyHistogram delivery;
+    QElapsedTimer clock;
+    qint64 last_delivery = 0;
+    QObject::connect(&transport, &LoopbackLinkTransport::peripheralReceived, &context,
+                     [&](const QByteArray &) {
+                         const qint64 now = clock.nsecsElapsed() / 1000;
+                         if (last_delivery)
+                             delivery.record(now - last_delivery);
+                         last_delivery = now;
+                     });
+
+    FrameScheduler *scheduler = controller.scheduler();
+    scheduler->setLinkInterval(connection_interval_ms * 1000);
+    transport.open();
+    startStickSweep(&controller, &context);
+
+    clock.start();
+    scheduler->resetCounters();
+    runEventLoop(duration);
+    const quint64 sent = scheduler->sentFrames();
+    scheduler->stop();
+    transport.close();
+
+    return {{"duration_ms", duration},
+            {"frame_interval_us", scheduler->effectiveFrameInterval()},
+            {"sent_frames", double(sent)},
+            {"frames_per_second", sent * 1000.0 / duration},
+            {"delivered_packets", double(transport.deliveredPackets())},
+            {"stale_frames_dropped", double(transport.staleFramesDropped())},
+            {"max_queue_depth", transport.maxQueueDepth()},
+            {"scheduler_jitter", percentiles(scheduler->jitterHistogram())},
+            {"delivery_interval", percentiles(delivery)}};
+}
+
+QJsonObject runMultiLink(const Options &options)
+{
+    const int duration = scaled(options, 3000);
+    constexpr int vehicles = 8;
+
+    QObject context;
+    LinkScheduler scheduler;
+    for (int i = 0; i < vehicles; ++i) {
+        VehicleLink *link = scheduler.addLoopbackLink(QStringLiteral("Vehicle %1").arg(i));
+        startStickSweep(link->controller(), &context);
+    }
+    runEventLoop(duration);
+    scheduler.clock()->stop();
+
+    double min_rate = 0;
+    double max_rate = 0;
+    LatencyHistogram intervals;
+    for (VehicleLink *link : scheduler.links()) {
+        const double rate = link->framesSent() * 1000.0 / duration;
+        min_rate = min_rate ? qMin(min_rate, rate) : rate;
+        max_rate = qMax(max_rate, rate);
+        intervals.merge(link->intervals());
+    }
+
+    return {{"duration_ms", duration},
+            {"links", vehicles},
+            {"frames_per_second_min", min_rate},
+            {"frames_per_second_max", max_rate},
+            {"scheduler_jitter", percentiles(scheduler.clock()->jitterHistogram())},
+            {"link_interval", percentiles(intervals)}};
+}
+
+const Register loopback("loopback_cadence", runLoopback);
+const Register multiLink("multi_link_cadence", runMultiLink);
+
+} // namespace
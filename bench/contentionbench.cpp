@@ -0,0 +1,106 @@
+#include "benchmark.h"
+
+#include <QReadWriteLock>
+
+#include <channelstate.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Benchmark;
+
+namespace {
+
+// the QReadWriteLock protected array ChannelState replaced
+class LockedChannels
+{
+public:
+    bool store(std::initializer_list<ChannelState::Update> updates)
+    {
+        QWriteLocker locker(&m_lock);
+        bool changed = false;
+        for (const ChannelState::Update &update : updates) {
+            changed |= m_channels[update.channel] != update.value;
+            m_channels[update.channel] = update.value;
+        }
+        return changed;
+    }
+
+    void load(ChannelState::Channels &channels)
+    {
+        QReadLocker locker(&m_lock);
+        channels = m_channels;
+    }
+
+private:
+    QReadWriteLock m_lock;
+    ChannelState::Channels m_channels{};
+};
+
+// two writers (touch and gamepad) hammer the state while the frame clock
+// reads it as fast as it can, reads are timed one in 64
+template<typename State>
+QJsonObject contend(State &state, std::chrono::milliseconds duration)
+{
+    using namespace std::chrono;
+
+    std::atomic<bool> stop{false};
+    std::atomic<quint64> writes{0};
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&, w]() {
+            quint64 count = 0;
+            qint16 value = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                ++value;
+                state.store({{2 * w, value}, {2 * w + 1, qint16(-value)}});
+                ++count;
+            }
+            writes += count;
+        });
+    }
+
+    LatencyHistogram read_latency;
+    quint64 reads = 0;
+    qint64 max_read_ns = 0;
+    ChannelState::Channels channels;
+    const steady_clock::time_point end = steady_clock::now() + duration;
+    while (steady_clock::now() < end) {
+        for (int i = 0; i < 63; ++i)
+            state.load(channels);
+        const steady_clock::time_point before = steady_clock::now();
+        state.load(channels);
+        const qint64 ns = duration_cast<nanoseconds>(steady_clock::now() - before).count();
+        max_read_ns = qMax(max_read_ns, ns);
+        read_latency.record(ns / 1000);
+        reads += 64;
+    }
+
+    stop = true;
+    for (std::thread &writer : writers)
+        writer.join();
+
+    const double seconds = duration_cast<duration<double>>(duration).count();
+    return {{"reads_per_second", reads / seconds},
+            {"writes_per_second", writes / seconds},
+            {"read_max_ns", double(max_read_ns)},
+            {"read_p99_us", double(read_latency.percentile(99))}};
+}
+
+QJsonObject runContention(const Options &options)
+{
+    const std::chrono::milliseconds duration(scaled(options, 2000));
+
+    ChannelState seqlock;
+    LockedChannels locked;
+    return {{"duration_ms", double(duration.count())},
+            {"writers", 2},
+            {"seqlock", contend(seqlock, duration)},
+            {"read_write_lock", contend(locked, duration)}};
+}
+
+const Register contention("channel_state_contention", runContention);
+
+} // namespace
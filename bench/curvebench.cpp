@@ -0,0 +1,112 @@
+#include "benchmark.h"
+
+#include <channelfilter.h>
+#include <channelmixer.h>
+#include <channelstate.h>
+#include <responsecurve.h>
+
+using namespace Benchmark;
+
+namespace {
+
+QJsonObject runCurves(const Options &options)
+{
+    const int frames = scaled(options, 1000000);
+
+    ChannelState::Channels input;
+    for (int i = 0; i < ChannelState::max_channels; ++i)
+        input[i] = qint16(-ResponseCurve::full_scale + i * 1250);
+
+    const ResponseCurve::Table &curve = ResponseCurve::preset(ResponseCurve::Expo50);
+    // keeps the compiler from dropping the loops
+    qint64 sink = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < frames; ++frame) {
+        ChannelState::Channels channels = input;
+        channels[frame % ChannelState::max_channels] = qint16(frame % ResponseCurve::full_scale);
+        for (qint16 &value : channels)
+            value = ResponseCurve::apply(curve, value);
+        sink += channels[frame % ChannelState::max_channels];
+    }
+    const qint64 curves = timer.nsecsElapsed();
+
+    const ChannelMixer::Matrix &mixer = ChannelMixer::preset(ChannelMixer::Elevon);
+    timer.restart();
+    for (int frame = 0; frame < frames; ++frame) {
+        ChannelState::Channels channels = input;
+        channels[frame % ChannelState::max_channels] = qint16(frame % ResponseCurve::full_scale);
+        ChannelMixer::mix(mixer, channels, channels);
+        sink += channels[frame % ChannelState::max_channels];
+    }
+    const qint64 mixing = timer.nsecsElapsed();
+
+    const int tables = scaled(options, 1000);
+    timer.restart();
+    for (int i = 0; i < tables; ++i)
+        sink += ResponseCurve::makeTable(0.3 + i * 1e-4, 1.0, 0.02)[10];
+    const qint64 building = timer.nsecsElapsed();
+
+    return {{"frames", frames},
+            {"channels", ChannelState::max_channels},
+            {"curve_ns_per_frame", double(curves) / frames},
+            {"mixer_ns_per_frame", double(mixing) / frames},
+            {"make_table_us", double(building) / tables / 1000.0},
+            {"checksum", double(sink)}};
+}
+
+// frames until a full stick throw reaches 90% of the target
+int stepResponseFrames(const ChannelFilter::Settings &settings, float seconds)
+{
+    ChannelFilter::State state;
+    ChannelState::Channels channels{};
+    ChannelFilter::apply(settings, state, seconds, channels, channels);
+
+    constexpr int target = ResponseCurve::full_scale;
+    for (int frame = 1; frame < 1000; ++frame) {
+        channels.fill(0);
+        channels[0] = qint16(target);
+        ChannelFilter::apply(settings, state, seconds, channels, channels);
+        if (channels[0] >= target * 9 / 10)
+            return frame;
+    }
+    return -1;
+}
+
+QJsonObject runFilters(const Options &options)
+{
+    const int frames = scaled(options, 1000000);
+    // the default FrameScheduler interval
+    constexpr float frame_seconds = 0.02f;
+    QJsonObject result{{"frames", frames}, {"channels", ChannelState::max_channels}};
+
+    for (int preset = ChannelFilter::Light; preset < ChannelFilter::PresetCount; ++preset) {
+        const ChannelFilter::Settings &settings = ChannelFilter::preset(ChannelFilter::Preset(preset));
+        ChannelFilter::State state;
+        ChannelState::Channels channels{};
+        qint64 sink = 0;
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int frame = 0; frame < frames; ++frame) {
+            // a jittery digitizer: a slow sweep plus a few units of noise
+            channels[frame % ChannelState::max_channels] = qint16(frame % ResponseCurve::full_scale
+                                                                  + (frame * 7919) % 9 - 4);
+            ChannelFilter::apply(settings, state, frame_seconds, channels, channels);
+            sink += channels[frame % ChannelState::max_channels];
+        }
+        const qint64 filtering = timer.nsecsElapsed();
+
+        result.insert(preset == ChannelFilter::Light ? "light" : "smooth",
+                      QJsonObject{{"ns_per_frame", double(filtering) / frames},
+                                  {"step_90_frames", stepResponseFrames(settings, frame_seconds)},
+                                  {"checksum", double(sink)}});
+    }
+    return result;
+}
+
+const Register curves("curves_16_channels", runCurves);
+const Register filters("filters_16_channels", runFilters);
+
+} // namespace
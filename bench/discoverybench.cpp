@@ -0,0 +1,101 @@
+#include "benchmark.h"
+
+#include <QBluetoothAddress>
+#include <QBluetoothDeviceInfo>
+
+#include <deviceinfo.h>
+#include <devicelistmodel.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace Benchmark;
+
+namespace {
+
+// at the flying field: hundreds of advertisers, each repeating every few
+// hundred milliseconds, 10k advertisements a second in total
+constexpr int target_events_per_second = 10000;
+constexpr int coalescing_interval_ms = 250;
+
+std::vector<QBluetoothDeviceInfo> advertisers(int count)
+{
+    std::vector<QBluetoothDeviceInfo> devices;
+    devices.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QBluetoothDeviceInfo info(QBluetoothAddress(0xC0FFEE000000ull + i),
+                                  QStringLiteral("Advertiser %1").arg(i),
+                                  0);
+        info.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+// what Device::addDevice did before the address index
+qint64 legacyIngest(const std::vector<QBluetoothDeviceInfo> &devices, int events)
+{
+    QList<DeviceInfo *> list;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < events; ++i) {
+        auto devInfo = new DeviceInfo(devices[i % devices.size()]);
+        auto it = std::find_if(list.begin(), list.end(), [devInfo](DeviceInfo *dev) {
+            return devInfo->getAddress() == dev->getAddress();
+        });
+        if (it == list.end()) {
+            list.append(devInfo);
+        } else {
+            auto oldDev = *it;
+            *it = devInfo;
+            delete oldDev;
+        }
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    qDeleteAll(list);
+    return elapsed;
+}
+
+QJsonObject runDiscovery(const Options &options)
+{
+    const int events = scaled(options, 100000);
+    const int flush_every = target_events_per_second * coalescing_interval_ms / 1000;
+    QJsonObject result{{"events", events}};
+
+    for (int count : {100, 500, 2000}) {
+        const std::vector<QBluetoothDeviceInfo> devices = advertisers(count);
+
+        DeviceListModel model;
+        int inserted_rows = 0;
+        QObject::connect(&model, &DeviceListModel::rowsInserted, [&](const QModelIndex &, int first, int last) {
+            inserted_rows += last - first + 1;
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < events; ++i) {
+            QBluetoothDeviceInfo info = devices[i % devices.size()];
+            info.setRssi(qint16(-40 - i % 50));
+            model.update(info);
+            if (i % flush_every == flush_every - 1)
+                model.flush();
+        }
+        model.flush();
+        const qint64 indexed = timer.nsecsElapsed();
+        const qint64 legacy = legacyIngest(devices, qMin(events, scaled(options, 20000)));
+        const int legacy_events = qMin(events, scaled(options, 20000));
+
+        result.insert(QString::number(count) + "_advertisers",
+                      QJsonObject{{"ns_per_event", double(indexed) / events},
+                                  {"events_per_second", events * 1e9 / indexed},
+                                  {"headroom", events * 1e9 / indexed / target_events_per_second},
+                                  {"rows", model.rowCount()},
+                                  {"inserted_rows", inserted_rows},
+                                  {"legacy_ns_per_event", double(legacy) / legacy_events}});
+    }
+    return result;
+}
+
+const Register discovery("discovery_ingestion", runDiscovery);
+
+} // namespace
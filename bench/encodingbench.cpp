@@ -0,0 +1,134 @@
+#include "benchmark.h"
+
+#include <QtEndian>
+
+#include <controllerobject.h>
+#include <controlprotocol.h>
+
+#include <array>
+#include <cmath>
+
+using namespace Benchmark;
+
+namespace {
+
+struct Format
+{
+    const char *name;
+    ControllerObject::FrameFormat format;
+};
+
+constexpr std::array<Format, 3> formats{{{"raw", ControllerObject::RawFormat},
+                                         {"protocol_v1", ControllerObject::ProtocolV1},
+                                         {"packed_v1", ControllerObject::PackedV1}}};
+
+constexpr double pi = 3.14159265358979323846;
+
+// slow sweeps like a pilot's thumbs, no two consecutive frames are equal
+std::array<double, 1024> stickPath()
+{
+    std::array<double, 1024> path;
+    for (size_t i = 0; i < path.size(); ++i)
+        path[i] = std::sin(i * 2.0 * pi / path.size());
+    return path;
+}
+
+// receiver side of PackedV1, acknowledges every keyframe right away
+void acknowledgeKeyframes(ControllerObject &controller, const QByteArray &frame)
+{
+    if (ControlProtocol::peekType(frame.constData(), frame.size())
+        == quint8(ControlProtocol::FrameType::PackedKeyframe))
+        controller.acknowledgeKeyframe(qFromLittleEndian<quint16>(frame.constData() + 2));
+}
+
+QJsonObject runEncoding(const Options &options)
+{
+    const int frames = scaled(options, 200000);
+    const std::array<double, 1024> path = stickPath();
+    QJsonObject result{{"frames", frames}, {"channels", 8}};
+
+    for (const Format &format : formats) {
+        // frames are built by hand below
+        ControllerObject controller(nullptr, nullptr);
+        controller.setFrameFormat(format.format);
+        controller.setChannelCount(8);
+        controller.setMaxFrameSize(244);
+
+        quint64 bytes = 0;
+        QObject::connect(&controller, &ControllerObject::dataUpdated, [&](const QByteArray &data) {
+            bytes += data.size();
+            acknowledgeKeyframes(controller, data);
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < frames; ++i) {
+            const double x = path[i % path.size()];
+            const double y = path[(i + 256) % path.size()];
+            controller.rightStickMoved(x, y);
+            controller.leftStickMoved(y, x);
+            controller.sendFrame();
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        QJsonObject metrics{{"ns_per_frame", double(elapsed) / frames},
+                            {"frames_per_second", frames * 1e9 / elapsed},
+                            {"mean_frame_bytes", double(bytes) / frames}};
+        if (format.format == ControllerObject::PackedV1) {
+            metrics.insert("keyframes", double(controller.keyframesSent()));
+            metrics.insert("deltas", double(controller.deltaFramesSent()));
+        }
+        result.insert(format.name, metrics);
+    }
+
+    // the stick slots alone, what a touch or gamepad event costs
+    ControllerObject controller;
+    controller.scheduler()->stop();
+    const int updates = scaled(options, 1000000);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < updates; ++i)
+        controller.rightStickMoved(path[i % path.size()], path[(i + 256) % path.size()]);
+    result.insert("stick_update_ns", double(timer.nsecsElapsed()) / updates);
+
+    return result;
+}
+
+// heap allocations per frame once the frame ring and encoder are warm
+QJsonObject runAllocations(const Options &options)
+{
+    const int frames = scaled(options, 20000);
+    const std::array<double, 1024> path = stickPath();
+    QJsonObject result{{"frames", frames}};
+
+    for (const Format &format : formats) {
+        ControllerObject controller;
+        controller.scheduler()->stop();
+        controller.setFrameFormat(format.format);
+        controller.setChannelCount(8);
+        QObject::connect(&controller, &ControllerObject::dataUpdated, [&](const QByteArray &data) {
+            acknowledgeKeyframes(controller, data);
+        });
+
+        for (int i = 0; i < 1000; ++i)
+            controller.sendFrame();
+
+        const quint64 before = allocations();
+        const quint64 ring_before = controller.frameAllocations();
+        for (int i = 0; i < frames; ++i) {
+            controller.rightStickMoved(path[i % path.size()], 0.0);
+            controller.sendFrame();
+        }
+        result.insert(format.name,
+                      QJsonObject{{"allocations_per_frame",
+                                   double(allocations() - before) / frames},
+                                  {"frame_ring_allocations",
+                                   double(controller.frameAllocations() - ring_before)}});
+    }
+    return result;
+}
+
+const Register encoding("encoding", runEncoding);
+const Register frame_allocations("frame_allocations", runAllocations);
+
+} // namespace
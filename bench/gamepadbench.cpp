@@ -0,0 +1,83 @@
+#include "benchmark.h"
+
+#include <QEventLoop>
+#include <QTemporaryFile>
+#include <QTimer>
+
+#include <controllerobject.h>
+#include <gamepadinput.h>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+#include <linux/input.h>
+
+#include <cmath>
+#endif
+
+using namespace Benchmark;
+
+namespace {
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+// a gamepad reporting both sticks every 4 ms
+constexpr int report_interval_us = 4000;
+
+QByteArray syntheticStream(int reports)
+{
+    QByteArray stream;
+    auto append = [&stream](qint64 us, int type, int code, int value) {
+        input_event event{};
+        event.input_event_sec = us / 1000000;
+        event.input_event_usec = us % 1000000;
+        event.type = type;
+        event.code = code;
+        event.value = value;
+        stream.append(reinterpret_cast<const char *>(&event), sizeof(event));
+    };
+
+    for (int i = 0; i < reports; ++i) {
+        const qint64 us = qint64(i) * report_interval_us;
+        const double phase = i * 0.01;
+        append(us, EV_ABS, ABS_X, int(30000 * std::sin(phase)));
+        append(us, EV_ABS, ABS_RY, int(30000 * std::cos(phase)));
+        append(us, EV_SYN, SYN_REPORT, 0);
+    }
+    return stream;
+}
+
+QJsonObject runGamepad(const Options &options)
+{
+    const int reports = scaled(options, 1000);
+
+    QTemporaryFile recording;
+    if (!recording.open())
+        return {{"skipped", "no temporary file"}};
+    recording.write(syntheticStream(reports));
+    recording.flush();
+
+    ControllerObject controller;
+    GamepadInput gamepad(&controller);
+    QEventLoop loop;
+    QObject::connect(&gamepad, &GamepadInput::replayFinished, &loop, &QEventLoop::quit);
+    if (!gamepad.replay(recording.fileName()))
+        return {{"skipped", "replay failed"}};
+    // bounded in case the end of the stream is never seen
+    QTimer::singleShot(2 * reports * report_interval_us / 1000 + 1000, &loop, &QEventLoop::quit);
+    loop.exec();
+    gamepad.stop();
+    controller.scheduler()->stop();
+
+    return {{"reports", reports},
+            {"frame_interval_us", controller.scheduler()->effectiveFrameInterval()},
+            {"event_to_state", percentiles(gamepad.eventToState())},
+            {"event_to_frame", percentiles(gamepad.eventToFrame())}};
+}
+#else
+QJsonObject runGamepad(const Options &)
+{
+    return {{"skipped", "evdev is Linux only"}};
+}
+#endif
+
+const Register gamepad("gamepad_replay", runGamepad);
+
+} // namespace
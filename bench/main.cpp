@@ -0,0 +1,89 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+
+#include <cstdio>
+
+#include "benchmark.h"
+
+#include <eventtrace.h>
+
+QList<Benchmark::Case> &Benchmark::registry()
+{
+    static QList<Case> cases;
+    return cases;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("remote_control_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless benchmarks of the control path, results as JSON");
+    parser.addHelpOption();
+    QCommandLineOption output({"o", "output"}, "Write the results to <file>.", "file");
+    QCommandLineOption filter({"f", "filter"}, "Only run cases containing <text>.", "text");
+    QCommandLineOption quick("quick", "Run with a tenth of the iterations.");
+    QCommandLineOption list("list", "List the cases and exit.");
+    QCommandLineOption trace("trace", "Record a Chrome trace of the run to <file>.", "file");
+    parser.addOptions({output, filter, quick, list, trace});
+    parser.process(app);
+
+    if (parser.isSet(list)) {
+        for (const Benchmark::Case &c : std::as_const(Benchmark::registry()))
+            std::printf("%s\n", c.name);
+        return 0;
+    }
+
+    Benchmark::Options options;
+    if (parser.isSet(quick))
+        options.scale = 0.1;
+
+    // also shows what recording costs, the cases run with tracing enabled
+    EventTrace::setEnabled(parser.isSet(trace));
+
+    QJsonArray results;
+    for (const Benchmark::Case &c : std::as_const(Benchmark::registry())) {
+        if (parser.isSet(filter) && !QString::fromLatin1(c.name).contains(parser.value(filter)))
+            continue;
+
+        std::fprintf(stderr, "running %s\n", c.name);
+        QJsonObject result = c.run(options);
+        result.insert("name", QString::fromLatin1(c.name));
+        results.append(result);
+        EventTrace::collect();
+    }
+
+    if (parser.isSet(trace) && !EventTrace::writeJson(parser.value(trace)))
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(parser.value(trace)));
+
+    const QJsonObject document{
+        {"suite", "remote_control_bench"},
+        {"version", REMOTE_CONTROL_APP_VERSION},
+        {"qt", qVersion()},
+        {"cpu", QSysInfo::currentCpuArchitecture()},
+        {"os", QSysInfo::prettyProductName()},
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"scale", options.scale},
+        {"cases", results},
+    };
+    const QByteArray json = QJsonDocument(document).toJson();
+
+    if (!parser.isSet(output)) {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        return 0;
+    }
+
+    QFile file(parser.value(output));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(file.fileName()));
+        return 1;
+    }
+    file.write(json);
+    return 0;
+}
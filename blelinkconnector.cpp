@@ -0,0 +1,267 @@
+#include "blelinkconnector.h"
+
+#include <QDebug>
+
+#include <blelinktransport.h>
+#include <eventtrace.h>
+
+#include <utility>
+
+namespace {
+// the same backoff Device uses for the primary vehicle
+constexpr int reconnect_initial_delay_ms = 250;
+constexpr int reconnect_max_delay_ms = 8000;
+} // namespace
+
+BleLinkConnector::BleLinkConnector(const QBluetoothDeviceInfo &device,
+                                   QLowEnergyController::RemoteAddressType addressType,
+                                   QObject *bluetoothContext,
+                                   QObject *parent)
+    : QObject{parent}
+    , m_device(device)
+    , m_address_type(addressType)
+    , m_bluetooth_context(bluetoothContext)
+{
+    m_reconnect_timer.setSingleShot(true);
+    connect(&m_reconnect_timer, &QTimer::timeout, this, &BleLinkConnector::reconnect);
+}
+
+BleLinkConnector::~BleLinkConnector()
+{
+    // the transport owns the controller by now
+    if (m_handed_over) {
+        if (m_controller)
+            m_controller->disconnect(this);
+        return;
+    }
+    dropController();
+}
+
+QString BleLinkConnector::name() const
+{
+    return m_device.name().isEmpty() ? m_device.address().toString() : m_device.name();
+}
+
+void BleLinkConnector::start()
+{
+    EVENT_TRACE_INSTANT("connection", "vehicleConnect");
+    QMetaObject::invokeMethod(
+        m_bluetooth_context,
+        [this]() { m_controller = QLowEnergyController::createCentral(m_device); },
+        Qt::BlockingQueuedConnection);
+
+    connect(m_controller, &QLowEnergyController::connected, this, [this]() {
+        QMetaObject::invokeMethod(m_controller, &QLowEnergyController::discoverServices);
+    });
+    connect(m_controller,
+            &QLowEnergyController::serviceDiscovered,
+            this,
+            &BleLinkConnector::serviceDiscovered);
+    connect(m_controller,
+            &QLowEnergyController::discoveryFinished,
+            this,
+            &BleLinkConnector::discoveryFinished);
+    connect(m_controller,
+            &QLowEnergyController::errorOccurred,
+            this,
+            &BleLinkConnector::controllerError);
+    connect(m_controller, &QLowEnergyController::disconnected, this, [this]() {
+        lost(tr("Disconnected"));
+    });
+
+    m_service_found = false;
+    QMetaObject::invokeMethod(m_controller,
+                              [central = m_controller.data(), type = m_address_type]() {
+                                  central->setRemoteAddressType(type);
+                                  central->connectToDevice();
+                              });
+}
+
+void BleLinkConnector::serviceDiscovered(const QBluetoothUuid &uuid)
+{
+    if (uuid != NordicUart::service_uuid || m_service_found || !m_controller)
+        return;
+
+    // a child of the controller, goes with it
+    QMetaObject::invokeMethod(
+        m_controller,
+        [this, &uuid]() { m_service = m_controller->createServiceObject(uuid, m_controller); },
+        Qt::BlockingQueuedConnection);
+    if (!m_service) {
+        lost(tr("Cannot create the RX/TX service"));
+        return;
+    }
+    m_service_found = true;
+
+    // like Device, no need to wait for the rest of the service discovery
+    connect(m_service,
+            &QLowEnergyService::stateChanged,
+            this,
+            &BleLinkConnector::serviceStateChanged);
+    QMetaObject::invokeMethod(m_service, [service = m_service]() {
+        service->discoverDetails(QLowEnergyService::SkipValueDiscovery);
+    });
+}
+
+void BleLinkConnector::discoveryFinished()
+{
+    if (!m_service_found)
+        lost(tr("Could not find the RX/TX service"));
+}
+
+void BleLinkConnector::serviceStateChanged(QLowEnergyService::ServiceState state)
+{
+    if (state == QLowEnergyService::RemoteServiceDiscovering)
+        return;
+    // a service of an earlier attempt may still have queued a change
+    if (!m_service || sender() != m_service)
+        return;
+    if (state != QLowEnergyService::RemoteServiceDiscovered) {
+        lost(tr("Service discovery failed"));
+        return;
+    }
+
+    QLowEnergyService *service = std::exchange(m_service, nullptr);
+    service->disconnect(this);
+
+    bool found = false;
+    BleLinkTransport *created = nullptr;
+    QMetaObject::invokeMethod(
+        m_bluetooth_context,
+        [&]() {
+            if (!m_controller)
+                return;
+
+            // the service lives on this thread
+            const QLowEnergyCharacteristic tx = service->characteristic(NordicUart::tx_uuid);
+            const QLowEnergyCharacteristic rx = service->characteristic(NordicUart::rx_uuid);
+            found = tx.isValid() && rx.isValid();
+            if (!found) {
+                service->deleteLater();
+                return;
+            }
+
+            if (m_transport) {
+                m_transport->setService(service, tx, rx);
+            } else {
+                created = new BleLinkTransport(m_controller, service, tx, rx);
+                // deleting the transport disconnects the vehicle
+                m_controller->setParent(created);
+                m_transport = created;
+            }
+            if (m_linked_service)
+                m_linked_service->deleteLater();
+            m_linked_service = service;
+
+            const QLowEnergyDescriptor notification = rx.descriptor(
+                QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
+            if (notification.isValid())
+                service->writeDescriptor(notification, QByteArray::fromHex("0100"));
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (!found) {
+        lost(tr("Missing Rx or Tx characteristics"));
+        return;
+    }
+
+    m_reconnect_attempt = 0;
+    if (!created) {
+        qInfo() << "Vehicle" << name() << "reconnected";
+        return;
+    }
+
+    m_handed_over = true;
+    qInfo() << "Vehicle" << name() << "connected";
+    emit connected(created);
+}
+
+void BleLinkConnector::controllerError()
+{
+    QString reason;
+    QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
+    QMetaObject::invokeMethod(
+        m_bluetooth_context,
+        [&]() {
+            if (!m_controller)
+                return;
+            reason = m_controller->errorString();
+            state = m_controller->state();
+        },
+        Qt::BlockingQueuedConnection);
+
+    // a failed connect attempt does not emit disconnected()
+    if (!m_handed_over || state == QLowEnergyController::UnconnectedState)
+        lost(reason);
+    else
+        qWarning() << "Vehicle" << name() << "error:" << reason;
+}
+
+void BleLinkConnector::lost(const QString &reason)
+{
+    if (!m_handed_over) {
+        fail(reason);
+        return;
+    }
+
+    if (m_reconnect_timer.isActive())
+        return;
+
+    qWarning() << "Vehicle" << name() << "lost:" << reason;
+    // a half set up connection is dropped before trying again
+    if (m_controller)
+        QMetaObject::invokeMethod(m_controller, &QLowEnergyController::disconnectFromDevice);
+    scheduleReconnect();
+}
+
+void BleLinkConnector::scheduleReconnect()
+{
+    const int delay = qMin(reconnect_initial_delay_ms << qMin(m_reconnect_attempt, 5),
+                           reconnect_max_delay_ms);
+    ++m_reconnect_attempt;
+    qInfo() << "Reconnecting vehicle" << name() << "in" << delay << "ms";
+    m_reconnect_timer.start(delay);
+}
+
+void BleLinkConnector::reconnect()
+{
+    if (!m_controller)
+        return;
+
+    EVENT_TRACE_INSTANT("connection", "vehicleReconnect");
+    m_service_found = false;
+    // a service left over from an attempt that did not finish
+    QLowEnergyService *stale = std::exchange(m_service, nullptr);
+    if (stale)
+        stale->disconnect(this);
+    QMetaObject::invokeMethod(m_controller,
+                              [central = m_controller.data(), stale, type = m_address_type]() {
+                                  if (stale)
+                                      stale->deleteLater();
+                                  central->setRemoteAddressType(type);
+                                  central->connectToDevice();
+                              });
+}
+
+void BleLinkConnector::fail(const QString &reason)
+{
+    if (!m_controller)
+        return;
+
+    dropController();
+    qWarning() << "Vehicle" << name() << "failed:" << reason;
+    emit failed(reason);
+}
+
+void BleLinkConnector::dropController()
+{
+    if (!m_controller)
+        return;
+
+    m_controller->disconnect(this);
+    QMetaObject::invokeMethod(m_controller, &QLowEnergyController::disconnectFromDevice);
+    // the service is a child of the controller
+    m_controller->deleteLater();
+    m_controller = nullptr;
+    m_service = nullptr;
+}
@@ -0,0 +1,70 @@
+#ifndef BLELINKCONNECTOR_H
+#define BLELINKCONNECTOR_H
+
+#include <QBluetoothDeviceInfo>
+#include <QLowEnergyController>
+#include <QLowEnergyService>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class BleLinkTransport;
+
+// Connects one more peripheral next to Device's own connection: its own
+// QLowEnergyController on the Bluetooth thread, the RX/TX service and a
+// BleLinkTransport for it. Once connected it keeps reconnecting the same
+// controller with backoff, like Device does for the primary vehicle, and
+// hands the new service to the transport. Keep it for as long as the link.
+//
+// Lives on the GUI thread, the controller and transport are created on the
+// thread of bluetoothContext.
+class BleLinkConnector : public QObject
+{
+    Q_OBJECT
+public:
+    BleLinkConnector(const QBluetoothDeviceInfo &device,
+                     QLowEnergyController::RemoteAddressType addressType,
+                     QObject *bluetoothContext,
+                     QObject *parent = nullptr);
+    ~BleLinkConnector();
+
+    QString name() const;
+    void start();
+
+signals:
+    // first connect only, the receiver owns the transport, the transport
+    // owns the controller
+    void connected(BleLinkTransport *transport);
+    // the first connect failed, there is no retry
+    void failed(const QString &reason);
+
+private:
+    void serviceDiscovered(const QBluetoothUuid &uuid);
+    void discoveryFinished();
+    void serviceStateChanged(QLowEnergyService::ServiceState state);
+    void controllerError();
+    // lost or could not restore the connection
+    void lost(const QString &reason);
+    void scheduleReconnect();
+    void reconnect();
+    void fail(const QString &reason);
+    void dropController();
+
+    QBluetoothDeviceInfo m_device;
+    QLowEnergyController::RemoteAddressType m_address_type;
+    QObject *m_bluetooth_context = nullptr;
+    // owned by the transport once connected
+    QPointer<QLowEnergyController> m_controller;
+    // discovered by the current connect attempt
+    QLowEnergyService *m_service = nullptr;
+    bool m_service_found = false;
+    // the transport exists, set on the GUI thread
+    bool m_handed_over = false;
+    // only touched on the Bluetooth thread
+    QPointer<BleLinkTransport> m_transport;
+    QLowEnergyService *m_linked_service = nullptr;
+    QTimer m_reconnect_timer;
+    int m_reconnect_attempt = 0;
+};
+
+#endif // BLELINKCONNECTOR_H
@@ -0,0 +1,292 @@
+#include "blelinktransport.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QLowEnergyConnectionParameters>
+#include <QLowEnergyController>
+#include <QLowEnergyService>
+#include <QThread>
+#include <QTimer>
+
+#include <eventtrace.h>
+#include <inputtrace.h>
+
+#include <array>
+#include <atomic>
+
+namespace {
+// Asks a transport to flush on its own thread. A transport has at most one
+// posted (m_flush_posted), they come from a small static pool so a frame
+// written from the clock thread does not allocate.
+class FlushEvent : public QEvent
+{
+public:
+    FlushEvent()
+        : QEvent(eventType())
+    {}
+
+    static QEvent::Type eventType()
+    {
+        static const QEvent::Type type = QEvent::Type(QEvent::registerEventType());
+        return type;
+    }
+
+    static void *operator new(std::size_t size);
+    static void operator delete(void *memory);
+};
+
+constexpr int flush_event_pool_size = 16;
+
+struct FlushEventPool
+{
+    alignas(FlushEvent) std::array<std::array<unsigned char, sizeof(FlushEvent)>,
+                                   flush_event_pool_size> slots;
+    std::array<std::atomic<bool>, flush_event_pool_size> used{};
+};
+
+FlushEventPool flush_event_pool;
+
+void *FlushEvent::operator new(std::size_t size)
+{
+    if (size == sizeof(FlushEvent)) {
+        for (int i = 0; i < flush_event_pool_size; ++i) {
+            if (!flush_event_pool.used[i].exchange(true, std::memory_order_acquire))
+                return flush_event_pool.slots[i].data();
+        }
+    }
+    // more transports than slots, still correct
+    return ::operator new(size);
+}
+
+void FlushEvent::operator delete(void *memory)
+{
+    for (int i = 0; i < flush_event_pool_size; ++i) {
+        if (memory == flush_event_pool.slots[i].data()) {
+            flush_event_pool.used[i].store(false, std::memory_order_release);
+            return;
+        }
+    }
+    ::operator delete(memory);
+}
+} // namespace
+
+BleLinkTransport::BleLinkTransport(QLowEnergyController *controller,
+                                   QLowEnergyService *service,
+                                   const QLowEnergyCharacteristic &tx,
+                                   const QLowEnergyCharacteristic &rx,
+                                   QObject *parent)
+    : LinkTransport{parent}
+    , m_controller(controller)
+{
+    // registered up front, the first write may come from the clock thread
+    FlushEvent::eventType();
+
+    // without them the transport never becomes ready, e.g. in tests
+    if (m_controller) {
+        m_mtu = m_controller->mtu();
+        connect(m_controller,
+                &QLowEnergyController::stateChanged,
+                this,
+                &BleLinkTransport::updateReady);
+        connect(m_controller, &QObject::destroyed, this, &BleLinkTransport::updateReady);
+        connect(m_controller, &QLowEnergyController::mtuChanged, this, [this](int mtu) {
+            m_mtu = mtu;
+            emit mtuChanged();
+        });
+        connect(m_controller,
+                &QLowEnergyController::connectionUpdated,
+                this,
+                [this](const QLowEnergyConnectionParameters &parameters) {
+                    // the granted interval is reported as a range of one value
+                    m_link_interval = qRound(parameters.minimumInterval() * 1000);
+                    setConnectionInterval(qMax(1, qRound(parameters.minimumInterval())));
+                    emit linkIntervalChanged();
+                });
+    }
+
+    m_refill_timer = new QTimer(this);
+    m_refill_timer->setTimerType(Qt::PreciseTimer);
+    m_refill_timer->setInterval(m_connection_interval);
+    connect(m_refill_timer, &QTimer::timeout, this, &BleLinkTransport::refill);
+    m_in_flight.reserve(m_packets_per_interval);
+    setService(service, tx, rx);
+}
+
+void BleLinkTransport::setService(QLowEnergyService *service,
+                                  const QLowEnergyCharacteristic &tx,
+                                  const QLowEnergyCharacteristic &rx)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    if (m_service)
+        m_service->disconnect(this);
+    m_service = service;
+    m_tx = tx;
+    m_rx = rx;
+    m_credits = m_packets_per_interval;
+    m_awaiting_response = 0;
+
+    // fall back to acknowledged writes when the vehicle does not take
+    // unacknowledged ones
+    const QLowEnergyCharacteristic::PropertyTypes txProperties = m_tx.properties();
+    m_with_response = !(txProperties & QLowEnergyCharacteristic::WriteNoResponse)
+                      && (txProperties & QLowEnergyCharacteristic::Write);
+
+    if (m_service) {
+        connect(m_service, &QObject::destroyed, this, &BleLinkTransport::updateReady);
+        if (m_with_response) {
+            connect(m_service,
+                    &QLowEnergyService::characteristicWritten,
+                    this,
+                    [this](const QLowEnergyCharacteristic &ch) {
+                        if (ch.uuid() == m_tx.uuid())
+                            returnCredit();
+                    });
+            connect(m_service,
+                    &QLowEnergyService::errorOccurred,
+                    this,
+                    [this](QLowEnergyService::ServiceError error) {
+                        if (error == QLowEnergyService::CharacteristicWriteError)
+                            returnCredit();
+                    });
+        }
+        connect(m_service,
+                &QLowEnergyService::characteristicChanged,
+                this,
+                [this](const QLowEnergyCharacteristic &ch, const QByteArray &data) {
+                    if (ch.uuid() == m_rx.uuid()) {
+                        EVENT_TRACE_SCOPE("rx", "notification");
+                        emit dataReceived(data);
+                    }
+                });
+    }
+
+    // completions pace writes with response
+    if (m_with_response)
+        m_refill_timer->stop();
+    else
+        m_refill_timer->start();
+    updateReady();
+}
+
+bool BleLinkTransport::isReady() const
+{
+    return m_ready;
+}
+
+int BleLinkTransport::mtu() const
+{
+    return m_mtu;
+}
+
+bool BleLinkTransport::write(const QByteArray &data, WriteQueue::Kind kind)
+{
+    if (!m_write_queue.push(data, kind, InputTrace::current()))
+        qWarning() << "Link write queue full, dropped a message";
+
+    if (QThread::currentThread() == thread()) {
+        flush();
+        return true;
+    }
+
+    // QLowEnergyService is not thread safe, flush on the Bluetooth thread it
+    // lives in. Frames written before the flush runs are coalesced.
+    if (!m_flush_posted.exchange(true))
+        QCoreApplication::postEvent(this, new FlushEvent, Qt::HighEventPriority);
+    return true;
+}
+
+void BleLinkTransport::setConnectionInterval(int msec)
+{
+    m_connection_interval = qMax(msec, 1);
+    // the timer can only be restarted on its own thread
+    QMetaObject::invokeMethod(m_refill_timer, [this]() {
+        m_refill_timer->setInterval(m_connection_interval);
+    });
+}
+
+int BleLinkTransport::connectionInterval() const
+{
+    return m_connection_interval;
+}
+
+int BleLinkTransport::linkInterval() const
+{
+    return m_link_interval;
+}
+
+void BleLinkTransport::setPacketsPerInterval(int count)
+{
+    m_packets_per_interval = qMax(count, 1);
+}
+
+bool BleLinkTransport::event(QEvent *event)
+{
+    if (event->type() == FlushEvent::eventType()) {
+        flush();
+        return true;
+    }
+    return LinkTransport::event(event);
+}
+
+void BleLinkTransport::flush()
+{
+    m_flush_posted = false;
+    const int budget = m_with_response ? m_packets_per_interval - m_awaiting_response
+                                       : m_credits;
+    if (budget <= 0)
+        return;
+
+    EVENT_TRACE_SCOPE("frame", "radioWrite");
+    EVENT_TRACE_COUNTER("frame", "writeQueueDepth", m_write_queue.depth());
+
+    // grows once after setPacketsPerInterval(), flushes do not allocate
+    if (m_in_flight.capacity() < budget)
+        m_in_flight.reserve(budget);
+    const int taken = m_write_queue.take(budget, m_in_flight);
+    if (!m_with_response)
+        m_credits -= taken;
+    for (const WriteQueue::Entry &entry : std::as_const(m_in_flight)) {
+        if (writeNow(entry) && m_with_response)
+            ++m_awaiting_response;
+    }
+    m_in_flight.clear();
+}
+
+void BleLinkTransport::refill()
+{
+    m_credits = m_packets_per_interval;
+    if (m_write_queue.depth() > 0)
+        flush();
+}
+
+void BleLinkTransport::returnCredit()
+{
+    if (m_awaiting_response > 0)
+        --m_awaiting_response;
+    if (m_write_queue.depth() > 0)
+        flush();
+}
+
+void BleLinkTransport::updateReady()
+{
+    const bool ready = m_controller && m_service && m_tx.isValid()
+                       && m_controller->state() == QLowEnergyController::DiscoveredState;
+    if (m_ready.exchange(ready) != ready)
+        emit readyChanged();
+}
+
+bool BleLinkTransport::writeNow(const WriteQueue::Entry &entry)
+{
+    if (!isReady())
+        return false;
+
+    InputTrace::mark(InputTrace::RadioWrite, entry.traceId);
+    markRadioWrite(entry);
+    m_service->writeCharacteristic(m_tx,
+                                   entry.data,
+                                   m_with_response
+                                       ? QLowEnergyService::WriteMode::WriteWithResponse
+                                       : QLowEnergyService::WriteMode::WriteWithoutResponse);
+    return true;
+}
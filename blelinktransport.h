@@ -0,0 +1,98 @@
+#ifndef BLELINKTRANSPORT_H
+#define BLELINKTRANSPORT_H
+
+#include "linktransport.h"
+
+#include <QBluetoothUuid>
+#include <QList>
+#include <QLowEnergyCharacteristic>
+#include <QPointer>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QLowEnergyController;
+class QLowEnergyService;
+class QTimer;
+QT_END_NAMESPACE
+
+// the Nordic UART service of the vehicles, frames are written to TX and
+// telemetry arrives as RX notifications
+namespace NordicUart {
+inline const QBluetoothUuid service_uuid("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}");
+inline const QBluetoothUuid rx_uuid("{6e400003-b5a3-f393-e0a9-e50e24dcca9e}");
+inline const QBluetoothUuid tx_uuid("{6e400002-b5a3-f393-e0a9-e50e24dcca9e}");
+} // namespace NordicUart
+
+// Writes are paced by a credit budget. WriteWithoutResponse has no
+// completion on most backends, its credits refill once per connection
+// interval. A TX characteristic that only takes WriteWithResponse gets a
+// credit back from every characteristicWritten (or failed write) instead.
+// Created on the thread the controller lives in (Device's Bluetooth thread),
+// frames written from the frame clock are flushed there. isReady() and mtu()
+// are read from other threads, they are kept from the controller's signals.
+class BleLinkTransport : public LinkTransport
+{
+    Q_OBJECT
+public:
+    BleLinkTransport(QLowEnergyController *controller,
+                     QLowEnergyService *service,
+                     const QLowEnergyCharacteristic &tx,
+                     const QLowEnergyCharacteristic &rx,
+                     QObject *parent = nullptr);
+
+    // the service of a new connection on the same controller, e.g. after a
+    // reconnect. On the transport's thread only.
+    void setService(QLowEnergyService *service,
+                    const QLowEnergyCharacteristic &tx,
+                    const QLowEnergyCharacteristic &rx);
+
+    bool isReady() const override;
+    int mtu() const override;
+    bool write(const QByteArray &data, WriteQueue::Kind kind = WriteQueue::ControlFrame) override;
+
+    // safe to call from any thread
+    void setConnectionInterval(int msec);
+    int connectionInterval() const;
+    // connection interval the controller reported, microseconds, 0 until
+    // the first connection update
+    int linkInterval() const;
+    // packets the stack takes per connection event without queuing, or
+    // writes awaiting their response
+    void setPacketsPerInterval(int count);
+
+signals:
+    void linkIntervalChanged();
+
+protected:
+    bool event(QEvent *event) override;
+
+private:
+    void flush();
+    void refill();
+    // a write with response completed or failed
+    void returnCredit();
+    void updateReady();
+    bool writeNow(const WriteQueue::Entry &entry);
+
+    QPointer<QLowEnergyController> m_controller;
+    QPointer<QLowEnergyService> m_service;
+    QLowEnergyCharacteristic m_tx;
+    QLowEnergyCharacteristic m_rx;
+    QTimer *m_refill_timer = nullptr;
+    std::atomic<bool> m_ready{false};
+    std::atomic<int> m_mtu{23};
+    std::atomic<int> m_connection_interval{15};
+    std::atomic<int> m_link_interval{0};
+    // written from any thread, read by the refill on the transport's
+    std::atomic<int> m_packets_per_interval{4};
+    // only touched on the transport's thread
+    int m_credits = 4;
+    int m_awaiting_response = 0;
+    bool m_with_response = false;
+    std::atomic<bool> m_flush_posted{false};
+    // reused by every flush
+    QList<WriteQueue::Entry> m_in_flight;
+};
+
+#endif // BLELINKTRANSPORT_H
@@ -0,0 +1,89 @@
+#include "channelencoder.h"
+
+using namespace ControlProtocol;
+
+ChannelEncoder::ChannelEncoder() = default;
+
+void ChannelEncoder::setResolution(int bits)
+{
+    m_resolution = qBound(min_resolution, bits, max_resolution);
+}
+
+void ChannelEncoder::setMaxFrameSize(int bytes)
+{
+    m_max_frame_size = qMax(bytes, packed_keyframe_overhead);
+}
+
+int ChannelEncoder::effectiveResolution(int channelCount) const
+{
+    return usableResolution(channelCount, m_resolution, m_max_frame_size);
+}
+
+int ChannelEncoder::usableResolution(int channelCount, int preferred, int maxSize)
+{
+    const int bits = fitResolution(channelCount, preferred, maxSize);
+    return bits >= min_usable_resolution || bits == preferred ? bits : 0;
+}
+
+void ChannelEncoder::setKeyframeInterval(int frames)
+{
+    m_keyframe_interval = qMax(frames, 1);
+}
+
+int ChannelEncoder::encode(const ChannelFrame &frame, char *out)
+{
+    if (m_reset.exchange(false)) {
+        m_history_valid.fill(false);
+        m_base_valid = false;
+        m_applied_ack = m_ack.load();
+    }
+
+    const quint32 ack = m_ack.load(std::memory_order_acquire);
+    if (ack != m_applied_ack) {
+        m_applied_ack = ack;
+        for (int i = 0; i < history_size; ++i) {
+            if (m_history_valid[i] && m_history[i].sequence == quint16(ack)) {
+                m_base = m_history[i];
+                m_base_valid = true;
+                break;
+            }
+        }
+    }
+
+    const int maxSize = m_max_frame_size;
+    const int bits = usableResolution(frame.channelCount, m_resolution, maxSize);
+    if (!bits)
+        return 0;
+
+    if (m_base_valid && m_base.resolution == bits && m_base.channelCount == frame.channelCount
+        && m_frames_since_keyframe < m_keyframe_interval) {
+        ++m_frames_since_keyframe;
+        if (const int size = encodePackedDelta(frame, m_base, out, maxSize)) {
+            ++m_deltas;
+            return size;
+        }
+    }
+
+    ChannelFrame keyframe = frame;
+    keyframe.type = FrameType::PackedKeyframe;
+    keyframe.resolution = bits;
+    for (int i = 0; i < keyframe.channelCount; ++i)
+        keyframe.channels[i] = quantize(keyframe.channels[i], bits);
+
+    m_history[m_history_next] = keyframe;
+    m_history_valid[m_history_next] = true;
+    m_history_next = (m_history_next + 1) % history_size;
+    m_frames_since_keyframe = 0;
+    ++m_keyframes;
+    return encodePackedKeyframe(keyframe, out);
+}
+
+void ChannelEncoder::acknowledge(quint16 keyframeSequence)
+{
+    m_ack.store(quint32(keyframeSequence) | 0x10000, std::memory_order_release);
+}
+
+void ChannelEncoder::reset()
+{
+    m_reset = true;
+}
@@ -0,0 +1,71 @@
+#ifndef CHANNELENCODER_H
+#define CHANNELENCODER_H
+
+#include <controlprotocol.h>
+
+#include <array>
+#include <atomic>
+
+// Stateful packed frame encoder. Sends keyframes until the receiver
+// acknowledges one, then deltas against the newest acknowledged keyframe,
+// with a fresh keyframe every keyframeInterval frames. Resolution is lowered
+// automatically until a keyframe fits into maxFrameSize, but not below
+// min_usable_resolution.
+//
+// encode() belongs to the frame clock thread, acknowledge() and the setters
+// may be called from any thread.
+class ChannelEncoder
+{
+public:
+    // fewer bits make the sticks visibly stepped, packed frames are refused
+    // rather than sent that coarse
+    static constexpr int min_usable_resolution = 8;
+
+    ChannelEncoder();
+
+    void setResolution(int bits);
+    int resolution() const { return m_resolution; }
+    // what encode() uses for channelCount channels with the current settings,
+    // 0 if it would have to drop below min_usable_resolution
+    int effectiveResolution(int channelCount) const;
+    // largest write the link accepts, ATT MTU - 3
+    void setMaxFrameSize(int bytes);
+    int maxFrameSize() const { return m_max_frame_size; }
+    void setKeyframeInterval(int frames);
+
+    // frame.channels, channelCount, sequence and timestamp have to be set,
+    // out must hold maxFrameSize() bytes; returns the frame size or 0 if not
+    // even a keyframe at min_usable_resolution fits
+    int encode(const ControlProtocol::ChannelFrame &frame, char *out);
+
+    void acknowledge(quint16 keyframeSequence);
+    // forget acknowledged keyframes, e.g. after the link was re-established
+    void reset();
+
+    quint64 keyframes() const { return m_keyframes; }
+    quint64 deltas() const { return m_deltas; }
+
+private:
+    static constexpr int history_size = 8;
+
+    static int usableResolution(int channelCount, int preferred, int maxSize);
+
+    std::array<ControlProtocol::ChannelFrame, history_size> m_history{};
+    std::array<bool, history_size> m_history_valid{};
+    int m_history_next = 0;
+    ControlProtocol::ChannelFrame m_base;
+    bool m_base_valid = false;
+    int m_frames_since_keyframe = 0;
+    quint32 m_applied_ack = 0;
+
+    // sequence | 0x10000 once set, so 0 means no acknowledgement yet
+    std::atomic<quint32> m_ack{0};
+    std::atomic<bool> m_reset{false};
+    std::atomic<int> m_resolution{11};
+    std::atomic<int> m_max_frame_size{20};
+    std::atomic<int> m_keyframe_interval{50};
+    std::atomic<quint64> m_keyframes{0};
+    std::atomic<quint64> m_deltas{0};
+};
+
+#endif // CHANNELENCODER_H
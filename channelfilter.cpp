@@ -0,0 +1,107 @@
+#include "channelfilter.h"
+
+#include <responsecurve.h>
+
+#include <cmath>
+#include <limits>
+
+namespace ChannelFilter {
+
+namespace {
+enum Channel { StickChannelCount = 4 };
+constexpr float two_pi = 6.28318530718f;
+// a long pause between frames must not let the slew limit jump
+constexpr float max_step_seconds = 0.05f;
+// less than half a channel unit apart rounds to the same value
+constexpr float settled_distance = 0.5f;
+
+// smoothing factor of an exponential low-pass with this cutoff
+inline float alpha(float cutoff, float seconds)
+{
+    const float x = two_pi * cutoff * seconds;
+    return x / (x + 1.0f);
+}
+
+Settings makeSettings(float deadband, float minCutoff, float beta, float slewRate)
+{
+    Settings settings;
+    // AUX switches pass through unfiltered
+    for (int i = 0; i < StickChannelCount; ++i) {
+        settings.deadband[i] = deadband;
+        settings.minCutoff[i] = minCutoff;
+        settings.beta[i] = beta;
+        settings.derivativeCutoff[i] = 1.0f;
+        settings.slewRate[i] = slewRate;
+    }
+    return settings;
+}
+
+std::array<Settings, PresetCount> makePresets()
+{
+    std::array<Settings, PresetCount> presets;
+    presets[Light] = makeSettings(20.0f, 3.0f, 2.0f, 0.0f);
+    // full throw, 2 * full_scale, in half a second
+    presets[Smooth] = makeSettings(40.0f, 1.0f, 0.5f, 4.0f * ResponseCurve::full_scale);
+    return presets;
+}
+} // namespace
+
+const Settings &preset(Preset preset)
+{
+    static const std::array<Settings, PresetCount> presets = makePresets();
+    return presets[preset < PresetCount ? preset : NoFilter];
+}
+
+bool apply(const Settings &settings,
+           State &state,
+           float seconds,
+           const ChannelState::Channels &input,
+           ChannelState::Channels &output)
+{
+    alignas(32) Row x;
+    for (int i = 0; i < size; ++i)
+        x[i] = input[i];
+
+    if (!state.primed) {
+        state.held = x;
+        state.smoothed = x;
+        state.derivative.fill(0.0f);
+        state.output = x;
+        state.primed = true;
+        output = input;
+        return true;
+    }
+
+    const float dt = qBound(1e-4f, seconds, max_step_seconds);
+    constexpr float unlimited = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < size; ++i) {
+        const bool moved = std::fabs(x[i] - state.held[i]) > settings.deadband[i];
+        state.held[i] = moved ? x[i] : state.held[i];
+    }
+
+    for (int i = 0; i < size; ++i) {
+        const float target = state.held[i];
+        const float speed = (target - state.smoothed[i]) / dt;
+        state.derivative[i] += alpha(settings.derivativeCutoff[i], dt)
+                               * (speed - state.derivative[i]);
+        const float cutoff = settings.minCutoff[i]
+                             + settings.beta[i] * std::fabs(state.derivative[i])
+                                   / ResponseCurve::full_scale;
+        const float smoothed = state.smoothed[i] + alpha(cutoff, dt) * (target - state.smoothed[i]);
+        state.smoothed[i] = settings.minCutoff[i] > 0.0f ? smoothed : target;
+    }
+
+    float distance = 0.0f;
+    for (int i = 0; i < size; ++i) {
+        const float step = settings.slewRate[i] > 0.0f ? settings.slewRate[i] * dt : unlimited;
+        const float previous = state.output[i];
+        const float value = qBound(previous - step, state.smoothed[i], previous + step);
+        state.output[i] = value;
+        distance = qMax(distance, std::fabs(value - state.held[i]));
+        output[i] = qint16(value < 0.0f ? value - 0.5f : value + 0.5f);
+    }
+    return distance < settled_distance;
+}
+
+} // namespace ChannelFilter
@@ -0,0 +1,68 @@
+#ifndef CHANNELFILTER_H
+#define CHANNELFILTER_H
+
+#include <channelstate.h>
+
+#include <array>
+
+// Per channel input filtering, run on the frame clock before the response
+// curves, in this order:
+//   deadband   the output holds until the input moves further than this
+//              from it, hides digitizer jitter around a resting stick
+//   One Euro   low-pass whose cutoff rises with the speed of the input,
+//              smooth when slow, little lag when fast (Casiez et al. 2012)
+//   slew limit maximum change per second
+// A zero setting turns that step off for the channel. Every step works on
+// a fixed size row of floats so the loops vectorise.
+namespace ChannelFilter {
+
+constexpr int size = ChannelState::max_channels;
+using Row = std::array<float, size>;
+
+struct Settings
+{
+    // channel units
+    alignas(32) Row deadband{};
+    // Hz, the cutoff of a stick at rest
+    alignas(32) Row minCutoff{};
+    // Hz added per full scale per second of input speed
+    alignas(32) Row beta{};
+    // Hz, smoothing of the speed estimate
+    alignas(32) Row derivativeCutoff{};
+    // channel units per second
+    alignas(32) Row slewRate{};
+};
+
+// filter memory, owned by the thread that applies the filter
+struct State
+{
+    alignas(32) Row held{};
+    alignas(32) Row smoothed{};
+    alignas(32) Row derivative{};
+    alignas(32) Row output{};
+    bool primed = false;
+};
+
+enum Preset {
+    NoFilter,
+    // jitter removal, barely any added lag
+    Light,
+    // steadier camera and gimbal moves, rate limited
+    Smooth,
+    PresetCount
+};
+
+const Settings &preset(Preset preset);
+
+// seconds is the time since the previous frame. input and output may be the
+// same array. Returns false while the output is still moving towards the
+// input, the caller has to keep sending frames until it has settled.
+bool apply(const Settings &settings,
+           State &state,
+           float seconds,
+           const ChannelState::Channels &input,
+           ChannelState::Channels &output);
+
+} // namespace ChannelFilter
+
+#endif // CHANNELFILTER_H
@@ -0,0 +1,86 @@
+#include "channelmixer.h"
+
+#include <responsecurve.h>
+
+namespace ChannelMixer {
+
+namespace {
+enum Channel { Roll = 0, Pitch = 1, Throttle = 2, Yaw = 3, Aux1 = 4 };
+
+Matrix empty()
+{
+    Matrix matrix;
+    matrix.minimum.fill(-ResponseCurve::full_scale);
+    matrix.maximum.fill(ResponseCurve::full_scale);
+    return matrix;
+}
+
+// left = a + b and right = a - b, other outputs pass through
+Matrix mixPair(int left, int right, int a, int b)
+{
+    Matrix matrix = identity();
+    matrix.weights[left][left] = 0.0f;
+    matrix.weights[right][right] = 0.0f;
+    matrix.weights[a][left] = 1.0f;
+    matrix.weights[b][left] = 1.0f;
+    matrix.weights[a][right] = 1.0f;
+    matrix.weights[b][right] = -1.0f;
+    return matrix;
+}
+
+std::array<Matrix, PresetCount> makePresets()
+{
+    std::array<Matrix, PresetCount> presets;
+    presets[Direct] = identity();
+    presets[Elevon] = mixPair(Roll, Pitch, Pitch, Roll);
+    presets[VTail] = mixPair(Pitch, Yaw, Pitch, Yaw);
+    presets[Flaperon] = mixPair(Roll, Aux1, Aux1, Roll);
+    presets[DifferentialThrust] = mixPair(Throttle, Yaw, Throttle, Yaw);
+    return presets;
+}
+} // namespace
+
+Matrix identity()
+{
+    Matrix matrix = empty();
+    for (int i = 0; i < size; ++i)
+        matrix.weights[i][i] = 1.0f;
+    return matrix;
+}
+
+const Matrix &preset(Preset preset)
+{
+    static const std::array<Matrix, PresetCount> presets = makePresets();
+    return presets[preset < PresetCount ? preset : Direct];
+}
+
+int mixedOutputs(const Matrix &matrix)
+{
+    for (int o = size - 1; o >= 0; --o) {
+        if (matrix.offset[o] != 0.0f)
+            return o + 1;
+        for (int i = 0; i < size; ++i) {
+            if (matrix.weights[i][o] != (i == o ? 1.0f : 0.0f))
+                return o + 1;
+        }
+    }
+    return 0;
+}
+
+void mix(const Matrix &matrix, const ChannelState::Channels &input, ChannelState::Channels &output)
+{
+    alignas(32) Row accumulator = matrix.offset;
+    for (int i = 0; i < size; ++i) {
+        const float value = input[i];
+        const Row &weights = matrix.weights[i];
+        for (int o = 0; o < size; ++o)
+            accumulator[o] += weights[o] * value;
+    }
+
+    for (int o = 0; o < size; ++o) {
+        const float value = qBound(matrix.minimum[o], accumulator[o], matrix.maximum[o]);
+        output[o] = qint16(value < 0.0f ? value - 0.5f : value + 0.5f);
+    }
+}
+
+} // namespace ChannelMixer
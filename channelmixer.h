@@ -0,0 +1,50 @@
+#ifndef CHANNELMIXER_H
+#define CHANNELMIXER_H
+
+#include <channelstate.h>
+
+#include <array>
+
+// Linear mixer between stick input and frame encoding:
+//   output[o] = clamp(offset[o] + sum(weights[i][o] * input[i]), minimum[o], maximum[o])
+// Weights are stored input major so the inner loop runs over a contiguous,
+// fixed size row of outputs and vectorises.
+namespace ChannelMixer {
+
+constexpr int size = ChannelState::max_channels;
+using Row = std::array<float, size>;
+
+struct Matrix
+{
+    alignas(32) std::array<Row, size> weights{};
+    alignas(32) Row offset{};
+    alignas(32) Row minimum{};
+    alignas(32) Row maximum{};
+};
+
+enum Preset {
+    Direct,
+    // Roll and Pitch outputs drive the left and right elevon
+    Elevon,
+    // Pitch and Yaw outputs drive the left and right ruddervator
+    VTail,
+    // Roll and AUX 1 outputs drive the left and right flaperon, AUX 1 input
+    // is the flap
+    Flaperon,
+    // Throttle and Yaw outputs drive the left and right motor
+    DifferentialThrust,
+    PresetCount
+};
+
+Matrix identity();
+const Matrix &preset(Preset preset);
+// 1 + the highest output that does not just pass its input through, 0 for
+// identity. A frame must carry that many channels for the mix to arrive.
+int mixedOutputs(const Matrix &matrix);
+
+// input and output may be the same array
+void mix(const Matrix &matrix, const ChannelState::Channels &input, ChannelState::Channels &output);
+
+} // namespace ChannelMixer
+
+#endif // CHANNELMIXER_H
@@ -0,0 +1,107 @@
+#ifndef CHANNELSTATE_H
+#define CHANNELSTATE_H
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <initializer_list>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Seqlock protected channel values. Readers (the frame clock) never block a
+// writer. Writers are not lock free: an odd sequence marks a store in
+// progress and concurrent writers (touch, gamepad) wait for it like for a
+// spinlock. Both sides spin a few times and then yield, so a high priority
+// reader cannot starve a preempted writer on a single core.
+class ChannelState
+{
+public:
+    static constexpr int max_channels = 16;
+    // busy waits before a retry starts yielding the core
+    static constexpr int max_spins = 64;
+    using Channels = std::array<qint16, max_channels>;
+
+    struct Update
+    {
+        int channel;
+        qint16 value;
+    };
+
+    // returns true when at least one channel changed
+    bool store(std::initializer_list<Update> updates)
+    {
+        return store(updates.begin(), int(updates.size()));
+    }
+
+    bool store(const Update *updates, int count)
+    {
+        quint32 seq = m_sequence.load(std::memory_order_relaxed);
+        for (int spins = 0;; backoff(spins)) {
+            if (seq & 1) {
+                seq = m_sequence.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (m_sequence.compare_exchange_weak(seq,
+                                                 seq + 1,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed))
+                break;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        bool changed = false;
+        for (const Update *update = updates; update != updates + count; ++update) {
+            std::atomic<qint16> &slot = m_values[update->channel];
+            if (slot.load(std::memory_order_relaxed) != update->value) {
+                slot.store(update->value, std::memory_order_relaxed);
+                changed = true;
+            }
+        }
+
+        m_sequence.store(seq + 2, std::memory_order_release);
+        return changed;
+    }
+
+    // consistent snapshot of all channels, returns the sequence it belongs to
+    quint32 load(Channels &out) const
+    {
+        for (int spins = 0;; backoff(spins)) {
+            const quint32 before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            for (int i = 0; i < max_channels; ++i)
+                out[i] = m_values[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before)
+                return before;
+        }
+    }
+
+    qint16 value(int channel) const { return m_values[channel].load(std::memory_order_relaxed); }
+    quint32 sequence() const { return m_sequence.load(std::memory_order_acquire); }
+
+private:
+    static void backoff(int &spins)
+    {
+        if (++spins > max_spins) {
+            std::this_thread::yield();
+            return;
+        }
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    std::atomic<quint32> m_sequence{0};
+    std::array<std::atomic<qint16>, max_channels> m_values{};
+};
+
+#endif // CHANNELSTATE_H
@@ -0,0 +1,75 @@
+#include "characteristiclistmodel.h"
+
+CharacteristicListModel::CharacteristicListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{}
+
+CharacteristicListModel::~CharacteristicListModel()
+{
+    for (const Entry &entry : std::as_const(m_entries))
+        delete entry.characteristic;
+}
+
+int CharacteristicListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_entries.size());
+}
+
+QVariant CharacteristicListModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid))
+        return QVariant();
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return entry.name;
+    case UuidRole:
+        return entry.uuid;
+    case ValueRole:
+        return entry.value;
+    case PermissionRole:
+        return entry.permission;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> CharacteristicListModel::roleNames() const
+{
+    return {{NameRole, "characteristicName"},
+            {UuidRole, "characteristicUuid"},
+            {ValueRole, "characteristicValue"},
+            {PermissionRole, "characteristicPermission"}};
+}
+
+void CharacteristicListModel::append(CharacteristicInfo *characteristic)
+{
+    const int row = int(m_entries.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.append({characteristic, {}, {}, {}, {}});
+    format(m_entries.last());
+    endInsertRows();
+    emit countChanged();
+}
+
+void CharacteristicListModel::clear()
+{
+    if (m_entries.isEmpty())
+        return;
+
+    beginRemoveRows(QModelIndex(), 0, int(m_entries.size() - 1));
+    for (const Entry &entry : std::as_const(m_entries))
+        delete entry.characteristic;
+    m_entries.clear();
+    endRemoveRows();
+    emit countChanged();
+}
+
+void CharacteristicListModel::format(Entry &entry)
+{
+    entry.name = entry.characteristic->getName();
+    entry.uuid = entry.characteristic->getUuid();
+    entry.value = entry.characteristic->getValue();
+    entry.permission = entry.characteristic->getPermission();
+}
@@ -0,0 +1,54 @@
+#ifndef CHARACTERISTICLISTMODEL_H
+#define CHARACTERISTICLISTMODEL_H
+
+#include "characteristicinfo.h"
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include <QQmlEngine>
+
+// Characteristics of the selected service, owns the CharacteristicInfo
+// objects. Role data is formatted once when a characteristic is added or
+// updated.
+class CharacteristicListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+    QML_ANONYMOUS
+
+public:
+    enum Roles { NameRole = Qt::UserRole + 1, UuidRole, ValueRole, PermissionRole };
+
+    explicit CharacteristicListModel(QObject *parent = nullptr);
+    ~CharacteristicListModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void append(CharacteristicInfo *characteristic);
+    void clear();
+    qsizetype size() const { return m_entries.size(); }
+    CharacteristicInfo *at(qsizetype row) const { return m_entries.at(row).characteristic; }
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry
+    {
+        CharacteristicInfo *characteristic;
+        QString name;
+        QString uuid;
+        QString value;
+        QString permission;
+    };
+
+    static void format(Entry &entry);
+
+    QList<Entry> m_entries;
+};
+
+#endif // CHARACTERISTICLISTMODEL_H
@@ -1,59 +1,429 @@
 #include "controllerobject.h"
-#include <QReadLocker>
-#include <QReadWriteLock>
-#include <QWriteLocker>
-#include <device.h>
+#include <controlprotocol.h>
+#include <eventtrace.h>
+#include <inputtrace.h>
+
+#include <QDebug>
+
+#include <algorithm>
 
 namespace {
-enum Field { Roll = 0, Pitch = 2, Throttle = 4, Yaw = 6 };
-constexpr int double_to_int16_factor = 10000;
-QReadWriteLock lock;
+enum Channel { Roll = 0, Pitch = 1, Throttle = 2, Yaw = 3, StickChannelCount = 4 };
+constexpr int double_to_int16_factor = ResponseCurve::full_scale;
+// older input events did not cause the stick update, e.g. the return animation
+constexpr qint64 max_event_to_slot_ns = 100 * 1000 * 1000;
 } // namespace
 ControllerObject::ControllerObject(QObject *parent)
+    : ControllerObject{nullptr, parent}
+{
+    // runs on the frame clock thread
+    connect(m_scheduler, &FrameScheduler::frameDue, this, &ControllerObject::sendFrame,
+            Qt::DirectConnection);
+
+    m_scheduler->start();
+}
+
+ControllerObject::ControllerObject(FrameScheduler *clock, QObject *parent)
     : QObject{parent}
+    , m_scheduler(clock)
 {
-    // send 4 int16
-    // A E T R
+    // send int16 channels
+    // A E T R [AUX...]
     // A -> ROLL
     // E -> PITCH
     // T -> Throttle
     // R -> Yaw
-    m_data.resize(sizeof(int16_t) * 4, 0);
-    //rudder
-
-    m_data_timer = new QTimer(this);
-    connect(m_data_timer, &QTimer::timeout, this, [this]() {
-        QReadLocker locker(&lock);
-        emit dataUpdated(m_data);
-    });
+    m_clock.start();
+    m_effective_resolution = m_encoder.effectiveResolution(m_channel_count);
 
-    m_data_timer->start(20);
+    if (!m_scheduler) {
+        m_scheduler = new FrameScheduler(this);
+        m_own_scheduler = true;
+    }
 }
 
 ControllerObject::~ControllerObject()
 {
-    m_data_timer->stop();
+    if (m_own_scheduler)
+        m_scheduler->stop();
+}
+
+FrameScheduler *ControllerObject::scheduler() const
+{
+    return m_scheduler;
+}
+
+void ControllerObject::markChanged()
+{
+    m_changed = true;
+    m_scheduler->markChanged();
+}
+
+bool ControllerObject::hasChanged() const
+{
+    return m_changed;
+}
+
+quint64 ControllerObject::frameAllocations() const
+{
+    return m_frames.allocations();
+}
+
+ControllerObject::FrameFormat ControllerObject::frameFormat() const
+{
+    return m_frame_format;
+}
+
+void ControllerObject::setFrameFormat(FrameFormat format)
+{
+    if (m_frame_format.exchange(format) == format)
+        return;
+
+    if (format == RawFormat && m_mixer_channels > StickChannelCount) {
+        qWarning() << "RawFormat cannot carry the mixed AUX channels, mixer reset";
+        setMixerPreset(DirectMixer);
+    }
+    emit frameFormatChanged();
+}
+
+int ControllerObject::channelCount() const
+{
+    return m_channel_count;
+}
+
+void ControllerObject::setChannelCount(int count)
+{
+    count = qBound(qMax(int(StickChannelCount), m_mixer_channels),
+                   count,
+                   int(ControlProtocol::max_channels));
+    if (m_channel_count.exchange(count) == count)
+        return;
+
+    emit channelCountChanged();
+    updateEffectiveResolution();
+}
+
+int ControllerObject::packedResolution() const
+{
+    return m_encoder.resolution();
+}
+
+void ControllerObject::setPackedResolution(int bits)
+{
+    if (m_encoder.resolution() == bits)
+        return;
+
+    m_encoder.setResolution(bits);
+    emit packedResolutionChanged();
+    updateEffectiveResolution();
+}
+
+int ControllerObject::effectiveResolution() const
+{
+    return m_effective_resolution;
+}
+
+void ControllerObject::updateEffectiveResolution()
+{
+    const int bits = m_encoder.effectiveResolution(m_channel_count);
+    if (bits == m_effective_resolution)
+        return;
+
+    m_effective_resolution = bits;
+    if (bits == 0) {
+        qWarning() << "Packed frames disabled," << m_channel_count.load()
+                   << "channels do not fit" << m_encoder.maxFrameSize() << "bytes at"
+                   << ChannelEncoder::min_usable_resolution << "bits";
+    } else if (bits < m_encoder.resolution()) {
+        qWarning() << "Packed resolution lowered to" << bits << "bits to fit"
+                   << m_encoder.maxFrameSize() << "bytes";
+    }
+    emit effectiveResolutionChanged();
+}
+
+void ControllerObject::setMaxFrameSize(int bytes)
+{
+    m_encoder.setMaxFrameSize(bytes);
+    updateEffectiveResolution();
+}
+
+quint64 ControllerObject::keyframesSent() const
+{
+    return m_encoder.keyframes();
+}
+
+quint64 ControllerObject::deltaFramesSent() const
+{
+    return m_encoder.deltas();
+}
+
+void ControllerObject::acknowledgeKeyframe(quint16 sequence)
+{
+    m_encoder.acknowledge(sequence);
+}
+
+void ControllerObject::resetEncoder()
+{
+    m_encoder.reset();
+}
+
+void ControllerObject::setCurvePreset(int channel, CurvePreset preset)
+{
+    if (channel < 0 || channel >= ChannelState::max_channels)
+        return;
+
+    m_curves[channel].setPreset(preset == LinearCurve
+                                    ? nullptr
+                                    : &ResponseCurve::preset(ResponseCurve::Preset(preset)));
+    markChanged();
+}
+
+void ControllerObject::setCustomCurve(int channel, double expo, double rate, double deadband)
+{
+    if (channel < 0 || channel >= ChannelState::max_channels)
+        return;
+
+    m_curves[channel].setCustom(ResponseCurve::makeTable(qBound(0.0, expo, 1.0),
+                                                         qBound(0.0, rate, 1.25),
+                                                         qBound(0.0, deadband, 0.5)));
+    markChanged();
+}
+
+ControllerObject::FilterPreset ControllerObject::filterPreset() const
+{
+    return m_filter_preset;
+}
+
+void ControllerObject::setFilterPreset(FilterPreset preset)
+{
+    if (m_filter_preset == preset || preset < NoFilter || preset >= CustomFilter)
+        return;
+
+    m_filter_preset = preset;
+    m_filter.setPreset(preset == NoFilter ? nullptr
+                                          : &ChannelFilter::preset(ChannelFilter::Preset(preset)));
+    markChanged();
+    emit filterPresetChanged();
+}
+
+void ControllerObject::setCustomFilter(const ChannelFilter::Settings &settings)
+{
+    m_filter.setCustom(settings);
+    markChanged();
+    // any preset can be selected again afterwards
+    if (m_filter_preset != CustomFilter) {
+        m_filter_preset = CustomFilter;
+        emit filterPresetChanged();
+    }
+}
+
+ControllerObject::MixerPreset ControllerObject::mixerPreset() const
+{
+    return m_mixer_preset;
+}
+
+void ControllerObject::setMixerPreset(MixerPreset preset)
+{
+    if (m_mixer_preset == preset || preset < DirectMixer || preset >= CustomMixer)
+        return;
+
+    const ChannelMixer::Matrix *matrix = preset == DirectMixer
+                                             ? nullptr
+                                             : &ChannelMixer::preset(ChannelMixer::Preset(preset));
+    if (!fitMixerChannels(matrix))
+        return;
+
+    m_mixer_preset = preset;
+    m_mixer.setPreset(matrix);
+    markChanged();
+    emit mixerPresetChanged();
+}
+
+void ControllerObject::setCustomMixer(const ChannelMixer::Matrix &matrix)
+{
+    if (!fitMixerChannels(&matrix))
+        return;
+
+    m_mixer.setCustom(matrix);
+    markChanged();
+    // any preset can be selected again afterwards
+    if (m_mixer_preset != CustomMixer) {
+        m_mixer_preset = CustomMixer;
+        emit mixerPresetChanged();
+    }
+}
+
+bool ControllerObject::fitMixerChannels(const ChannelMixer::Matrix *matrix)
+{
+    const int outputs = matrix ? ChannelMixer::mixedOutputs(*matrix) : 0;
+    if (outputs > StickChannelCount && m_frame_format == RawFormat) {
+        qWarning() << "Mixer writes" << outputs << "channels, RawFormat only carries"
+                   << int(StickChannelCount);
+        return false;
+    }
+
+    m_mixer_channels = outputs;
+    if (outputs > m_channel_count)
+        setChannelCount(outputs);
+    return true;
+}
+
+void ControllerObject::setInputTracing(bool enabled)
+{
+    InputTrace::setEnabled(enabled);
+}
+
+QString ControllerObject::inputTraceReport() const
+{
+    return InputTrace::report();
+}
+
+void ControllerObject::setRecorder(FlightRecorder *recorder)
+{
+    m_recorder = recorder;
 }
 
 void ControllerObject::leftStickMoved(double x, double y)
 {
-    QWriteLocker locker(&lock);
-    setData(Yaw, x);
-    setData(Throttle, y);
+    const qint64 entered = InputTrace::isEnabled() ? InputTrace::now() : 0;
+    if (FlightRecorder *recorder = m_recorder.load(std::memory_order_relaxed))
+        recorder->recordStick(FlightLog::LeftStick, x, y);
+    if (m_channels.store({{Yaw, toChannelValue(x)}, {Throttle, toChannelValue(y)}})) {
+        traceInput(entered);
+        markChanged();
+    }
 }
 
 void ControllerObject::rightStickMoved(double x, double y)
 {
-    QWriteLocker locker(&lock);
-    setData(Roll, x);
-    setData(Pitch, y);
+    const qint64 entered = InputTrace::isEnabled() ? InputTrace::now() : 0;
+    if (FlightRecorder *recorder = m_recorder.load(std::memory_order_relaxed))
+        recorder->recordStick(FlightLog::RightStick, x, y);
+    if (m_channels.store({{Roll, toChannelValue(x)}, {Pitch, toChannelValue(y)}})) {
+        traceInput(entered);
+        markChanged();
+    }
+}
+
+void ControllerObject::traceInput(qint64 slotEntered)
+{
+    if (!slotEntered)
+        return;
+
+    // another writer may have stored in between, then that id wins
+    const quint32 id = m_channels.sequence();
+    const qint64 event = InputTrace::lastInputEvent();
+    if (event && slotEntered - event < max_event_to_slot_ns)
+        InputTrace::mark(InputTrace::TouchDispatched, id, event);
+    InputTrace::mark(InputTrace::StickSlot, id, slotEntered);
+    InputTrace::mark(InputTrace::StateStored, id);
+}
+
+void ControllerObject::setAuxChannel(int index, double value)
+{
+    const int channel = StickChannelCount + index;
+    if (index < 0 || channel >= ControlProtocol::max_channels)
+        return;
+
+    if (FlightRecorder *recorder = m_recorder.load(std::memory_order_relaxed))
+        recorder->recordAux(index, value);
+    if (m_channels.store({{channel, toChannelValue(value)}}))
+        markChanged();
+}
+
+quint32 ControllerObject::setChannels(const ChannelState::Update *updates, int count)
+{
+    if (!m_channels.store(updates, count))
+        return 0;
+
+    // another writer may have stored in between, then that sequence wins
+    const quint32 sequence = m_channels.sequence();
+    markChanged();
+    return sequence;
+}
+
+void ControllerObject::resetFrameState()
+{
+    m_sequence = 0;
+    m_encoder.reset();
+    m_filter_state = {};
+    m_last_frame_ns = 0;
+}
+
+void ControllerObject::sendFrame()
+{
+    sendFrameAt(m_clock.nsecsElapsed());
+}
+
+void ControllerObject::sendFrameAt(qint64 now)
+{
+    EVENT_TRACE_SCOPE("frame", "sendFrame");
+    // before the channels are read, a change after that shows up next time
+    m_changed = false;
+    ChannelState::Channels channels;
+    const quint32 traceId = m_channels.load(channels);
+    InputTrace::setCurrent(traceId);
+
+    const quint32 filter_generation = m_filter.generation();
+    if (filter_generation != m_filter_generation) {
+        m_filter_state = {};
+        m_filter_generation = filter_generation;
+    }
+    // keep frames coming until the filter output has caught up with the sticks
+    const ChannelFilter::Settings *filter = m_filter.acquire();
+    if (filter
+        && !ChannelFilter::apply(*filter, m_filter_state, (now - m_last_frame_ns) * 1e-9f,
+                                 channels, channels))
+        markChanged();
+    m_filter.release();
+    m_last_frame_ns = now;
+
+    for (int i = 0; i < ChannelState::max_channels; ++i) {
+        if (const ResponseCurve::Table *curve = m_curves[i].acquire())
+            channels[i] = ResponseCurve::apply(*curve, channels[i]);
+        m_curves[i].release();
+    }
+
+    if (const ChannelMixer::Matrix *mixer = m_mixer.acquire())
+        ChannelMixer::mix(*mixer, channels, channels);
+    m_mixer.release();
+
+    if (m_frame_format == RawFormat) {
+        QByteArray &frame = m_frames.acquire(sizeof(int16_t) * StickChannelCount);
+        char *out = frame.data();
+        for (int i = 0; i < StickChannelCount; ++i) {
+            out[2 * i] = char(channels[i] & 0xFF);
+            out[2 * i + 1] = char(channels[i] >> 8);
+        }
+        InputTrace::mark(InputTrace::FrameEncoded, traceId);
+        emit dataUpdated(frame);
+        return;
+    }
+
+    ControlProtocol::ChannelFrame header;
+    header.sequence = m_sequence++;
+    header.timestamp = quint32(now / 1000);
+    header.channelCount = m_channel_count;
+    std::copy_n(channels.begin(), header.channelCount, header.channels.begin());
+
+    if (m_frame_format == PackedV1) {
+        QByteArray &frame = m_frames.acquire(m_encoder.maxFrameSize());
+        const int size = m_encoder.encode(header, frame.data());
+        if (!size)
+            return;
+        frame.resize(size);
+        InputTrace::mark(InputTrace::FrameEncoded, traceId);
+        emit dataUpdated(frame);
+        return;
+    }
+
+    QByteArray &frame = m_frames.acquire(ControlProtocol::encodedSize(header.channelCount));
+    ControlProtocol::encode(header, frame.data());
+    InputTrace::mark(InputTrace::FrameEncoded, traceId);
+    emit dataUpdated(frame);
 }
 
-void ControllerObject::setData(int field, double data)
+qint16 ControllerObject::toChannelValue(double data)
 {
-    int16_t xVal = data * double_to_int16_factor;
-    int8_t low = xVal & 0xFF;
-    int8_t high = (xVal >> 8);
-    m_data[field] = low;
-    m_data[field + 1] = high;
+    return qint16(data * double_to_int16_factor);
 }
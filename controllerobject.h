@@ -1,30 +1,207 @@
 #ifndef CONTROLLEROBJECT_H
 #define CONTROLLEROBJECT_H
 
+#include <QElapsedTimer>
 #include <QObject>
-#include <QTimer>
+
+#include <channelencoder.h>
+#include <channelfilter.h>
+#include <channelmixer.h>
+#include <channelstate.h>
+#include <flightrecorder.h>
+#include <framering.h>
+#include <framescheduler.h>
+#include <responsecurve.h>
+#include <settingsslot.h>
+
+#include <array>
+#include <atomic>
 
 class ControllerObject : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(FrameScheduler *scheduler READ scheduler CONSTANT)
+    Q_PROPERTY(FrameFormat frameFormat READ frameFormat WRITE setFrameFormat
+                   NOTIFY frameFormatChanged)
+    Q_PROPERTY(int channelCount READ channelCount WRITE setChannelCount
+                   NOTIFY channelCountChanged)
+    Q_PROPERTY(int packedResolution READ packedResolution WRITE setPackedResolution
+                   NOTIFY packedResolutionChanged)
+    Q_PROPERTY(int effectiveResolution READ effectiveResolution
+                   NOTIFY effectiveResolutionChanged)
+    Q_PROPERTY(MixerPreset mixerPreset READ mixerPreset WRITE setMixerPreset
+                   NOTIFY mixerPresetChanged)
+    Q_PROPERTY(FilterPreset filterPreset READ filterPreset WRITE setFilterPreset
+                   NOTIFY filterPresetChanged)
 public:
+    enum FrameFormat {
+        // four bare int16 values, understood by older receivers
+        RawFormat,
+        // ControlProtocol version 1
+        ProtocolV1,
+        // ControlProtocol version 1, bit-packed keyframes and deltas
+        PackedV1
+    };
+    Q_ENUM(FrameFormat)
+
+    enum CurvePreset {
+        LinearCurve = ResponseCurve::Linear,
+        Expo30Curve = ResponseCurve::Expo30,
+        Expo50Curve = ResponseCurve::Expo50,
+        Expo70Curve = ResponseCurve::Expo70,
+        LowRateCurve = ResponseCurve::LowRate
+    };
+    Q_ENUM(CurvePreset)
+
+    enum MixerPreset {
+        DirectMixer = ChannelMixer::Direct,
+        ElevonMixer = ChannelMixer::Elevon,
+        VTailMixer = ChannelMixer::VTail,
+        FlaperonMixer = ChannelMixer::Flaperon,
+        DifferentialThrustMixer = ChannelMixer::DifferentialThrust,
+        // set by setCustomMixer(), cannot be selected as a preset
+        CustomMixer = ChannelMixer::PresetCount
+    };
+    Q_ENUM(MixerPreset)
+
+    enum FilterPreset {
+        NoFilter = ChannelFilter::NoFilter,
+        LightFilter = ChannelFilter::Light,
+        SmoothFilter = ChannelFilter::Smooth,
+        // set by setCustomFilter(), cannot be selected as a preset
+        CustomFilter = ChannelFilter::PresetCount
+    };
+    Q_ENUM(FilterPreset)
+
+    // clocked by a FrameScheduler of its own
     explicit ControllerObject(QObject *parent = nullptr);
+    // clocked from outside through sendFrame(), e.g. by LinkScheduler. Input
+    // changes wake clock and scheduler() returns it. With a null clock the
+    // own scheduler is never started and frames are left to the caller.
+    ControllerObject(FrameScheduler *clock, QObject *parent);
     ~ControllerObject();
-    const QByteArray &data() const;
+    FrameScheduler *scheduler() const;
+    // input or settings changed, wakes the clock. Safe to call from any thread.
+    void markChanged();
+    // changed since the last frame, a shared clock skips controllers without
+    // changes in OnChange mode
+    bool hasChanged() const;
+    // frame buffers that had to be allocated outside the preallocated ring
+    Q_INVOKABLE quint64 frameAllocations() const;
+
+    FrameFormat frameFormat() const;
+    void setFrameFormat(FrameFormat format);
+    // channels per frame, the four stick channels followed by AUX channels.
+    // Never lower than the channels the mixer writes.
+    int channelCount() const;
+    void setChannelCount(int count);
+    // bits per channel requested for PackedV1
+    int packedResolution() const;
+    void setPackedResolution(int bits);
+    // bits PackedV1 actually sends, packedResolution lowered until a frame
+    // fits the MTU. 0 when that would go below
+    // ChannelEncoder::min_usable_resolution, then no packed frames are sent.
+    int effectiveResolution() const;
+    // payload of a single write, ATT MTU - 3
+    void setMaxFrameSize(int bytes);
+
+    Q_INVOKABLE quint64 keyframesSent() const;
+    Q_INVOKABLE quint64 deltaFramesSent() const;
+
+    // response curve applied to a channel on the frame clock thread
+    Q_INVOKABLE void setCurvePreset(int channel, CurvePreset preset);
+    Q_INVOKABLE void setCustomCurve(int channel, double expo, double rate, double deadband);
+
+    // input filtering applied before the response curves
+    FilterPreset filterPreset() const;
+    void setFilterPreset(FilterPreset preset);
+    void setCustomFilter(const ChannelFilter::Settings &settings);
+
+    // mixing matrix applied after the response curves. A mix that writes
+    // AUX channels raises channelCount and is refused in RawFormat, which
+    // only carries the four stick channels.
+    MixerPreset mixerPreset() const;
+    void setMixerPreset(MixerPreset preset);
+    void setCustomMixer(const ChannelMixer::Matrix &matrix);
+
+    // safe to call from any thread, values are in channel units. Returns the
+    // ChannelState sequence that holds them, 0 if nothing changed.
+    quint32 setChannels(const ChannelState::Update *updates, int count);
+
+    // stick and AUX inputs are appended to the recorder while it records
+    void setRecorder(FlightRecorder *recorder);
+
+    // per hop latency from touch event to radio write, see InputTrace
+    Q_INVOKABLE void setInputTracing(bool enabled);
+    Q_INVOKABLE QString inputTraceReport() const;
 
 signals:
-    void dataUpdated(QByteArray);
+    // emitted on the frame clock thread, the buffer is reused a few frames
+    // later, so receivers that keep it must copy it
+    void dataUpdated(const QByteArray &data);
+    void frameFormatChanged();
+    void channelCountChanged();
+    void packedResolutionChanged();
+    void effectiveResolutionChanged();
+    void mixerPresetChanged();
+    void filterPresetChanged();
 
 public slots:
     void leftStickMoved(double x, double y);
     void rightStickMoved(double x, double y);
+    void setAuxChannel(int index, double value);
+    void acknowledgeKeyframe(quint16 sequence);
+    // start over with keyframes, e.g. after reconnecting
+    void resetEncoder();
+
+public:
+    // builds and emits one frame, on frameDue of the own scheduler or from
+    // the clock that was passed in
+    void sendFrame();
+    // same with a given frame time in nanoseconds, what the filter steps by
+    // and the header carries. Used by FlightReplay with the recorded times.
+    void sendFrameAt(qint64 timestampNs);
+    // sequence, encoder and filter start over like on a new controller. Only
+    // while no frame is being built, e.g. before a replay.
+    void resetFrameState();
 
 private:
-    void setData(int field, double data);
+    void traceInput(qint64 slotEntered);
+    void updateEffectiveResolution();
+    bool fitMixerChannels(const ChannelMixer::Matrix *matrix);
+    static qint16 toChannelValue(double data);
 
 protected:
-    QByteArray m_data;
-    QTimer *m_data_timer = nullptr;
+    ChannelState m_channels;
+    // only touched on the frame clock thread
+    FrameRing m_frames;
+    ChannelEncoder m_encoder;
+    int m_effective_resolution = 0;
+    // no settings skip filtering
+    SettingsSlot<ChannelFilter::Settings> m_filter;
+    FilterPreset m_filter_preset = NoFilter;
+    // only touched on the frame clock thread, restarts when the settings change
+    ChannelFilter::State m_filter_state;
+    quint32 m_filter_generation = 0;
+    qint64 m_last_frame_ns = 0;
+    // no curve passes the channel through unchanged
+    std::array<SettingsSlot<ResponseCurve::Table>, ChannelState::max_channels> m_curves;
+    // no matrix skips mixing
+    SettingsSlot<ChannelMixer::Matrix> m_mixer;
+    MixerPreset m_mixer_preset = DirectMixer;
+    // channels the active mix writes to
+    int m_mixer_channels = 0;
+    quint16 m_sequence = 0;
+    QElapsedTimer m_clock;
+    std::atomic<FlightRecorder *> m_recorder{nullptr};
+    // receivers in the field expect the raw values, V1 is opt in
+    std::atomic<FrameFormat> m_frame_format{RawFormat};
+    std::atomic<int> m_channel_count{4};
+    FrameScheduler *m_scheduler = nullptr;
+    // set by markChanged(), cleared as a frame is built
+    std::atomic<bool> m_changed{true};
+    // a shared clock may already be gone when this is destroyed
+    bool m_own_scheduler = false;
 };
 
 #endif // CONTROLLEROBJECT_H
@@ -0,0 +1,441 @@
+#include "controlprotocol.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+namespace ControlProtocol {
+
+namespace {
+constexpr quint16 crc_polynomial = 0x1021;
+
+constexpr std::array<quint16, 256> makeCrcTable()
+{
+    std::array<quint16, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        quint16 crc = quint16(i << 8);
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 0x8000) ? quint16((crc << 1) ^ crc_polynomial) : quint16(crc << 1);
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<quint16, 256> crc_table = makeCrcTable();
+static_assert(crc_table[1] == crc_polynomial);
+
+inline void put16(char *out, quint16 value)
+{
+    out[0] = char(value & 0xFF);
+    out[1] = char(value >> 8);
+}
+
+inline void put32(char *out, quint32 value)
+{
+    put16(out, quint16(value & 0xFFFF));
+    put16(out + 2, quint16(value >> 16));
+}
+
+inline quint16 get16(const char *in)
+{
+    return quint16(quint8(in[0]) | (quint8(in[1]) << 8));
+}
+
+inline quint32 get32(const char *in)
+{
+    return quint32(get16(in)) | (quint32(get16(in + 2)) << 16);
+}
+
+void putHeader(const ChannelFrame &frame, int channelCount, char *out)
+{
+    out[0] = char(sync_byte);
+    out[1] = char((version << 4) | (quint8(frame.type) & 0x0F));
+    put16(out + 2, frame.sequence);
+    put32(out + 4, frame.timestamp);
+    out[8] = char(channelCount);
+}
+
+int finish(char *out, int size)
+{
+    put16(out + size - crc_size, crc16(out, size - crc_size));
+    return size;
+}
+
+bool checkFrame(const char *data, qsizetype size, int frameSize)
+{
+    return frameSize <= size
+           && get16(data + frameSize - crc_size) == crc16(data, frameSize - crc_size);
+}
+
+// LSB first bit stream, writes whole bytes so out must be zeroed first
+class BitWriter
+{
+public:
+    explicit BitWriter(char *out)
+        : m_out(reinterpret_cast<quint8 *>(out))
+    {}
+
+    void write(quint32 value, int bits)
+    {
+        m_acc |= quint64(value & ((quint64(1) << bits) - 1)) << m_count;
+        m_count += bits;
+        while (m_count >= 8) {
+            *m_out++ = quint8(m_acc);
+            m_acc >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void flush()
+    {
+        if (m_count > 0)
+            *m_out++ = quint8(m_acc);
+        m_acc = 0;
+        m_count = 0;
+    }
+
+private:
+    quint8 *m_out;
+    quint64 m_acc = 0;
+    int m_count = 0;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const char *in)
+        : m_in(reinterpret_cast<const quint8 *>(in))
+    {}
+
+    quint32 read(int bits)
+    {
+        while (m_count < bits) {
+            m_acc |= quint64(*m_in++) << m_count;
+            m_count += 8;
+        }
+        const quint32 value = quint32(m_acc & ((quint64(1) << bits) - 1));
+        m_acc >>= bits;
+        m_count -= bits;
+        return value;
+    }
+
+private:
+    const quint8 *m_in;
+    quint64 m_acc = 0;
+    int m_count = 0;
+};
+
+// channels travel as unsigned offsets from INT16_MIN with the low bits cut
+inline quint32 toLevel(qint16 value, int resolution)
+{
+    return quint32(quint16(value + 32768)) >> (16 - resolution);
+}
+
+inline qint16 fromLevel(quint32 level, int resolution)
+{
+    const int shift = 16 - resolution;
+    const int half_step = shift ? 1 << (shift - 1) : 0;
+    return qint16(int((level << shift) + half_step) - 32768);
+}
+
+inline quint32 zigzag(int value)
+{
+    return value < 0 ? quint32(-value) * 2 - 1 : quint32(value) * 2;
+}
+
+inline int unzigzag(quint32 value)
+{
+    return (value & 1) ? -int((value + 1) / 2) : int(value / 2);
+}
+
+inline int bitWidth(quint32 value)
+{
+    return value ? 32 - int(qCountLeadingZeroBits(value)) : 0;
+}
+} // namespace
+
+int frameSize(const char *data, qsizetype size)
+{
+    if (size < header_size)
+        return 0;
+    if (quint8(data[0]) != sync_byte || (quint8(data[1]) >> 4) != version)
+        return -1;
+
+    const int count = quint8(data[8]);
+    switch (FrameType(quint8(data[1]) & 0x0F)) {
+    case FrameType::Channels:
+    case FrameType::Ack:
+    case FrameType::Ping:
+    case FrameType::Pong:
+        return count <= max_channels ? encodedSize(count) : -1;
+    case FrameType::PackedKeyframe: {
+        if (size < header_size + 1)
+            return 0;
+        const int bits = quint8(data[header_size]);
+        if (count > max_channels || bits < min_resolution || bits > max_resolution)
+            return -1;
+        return packedKeyframeSize(count, bits);
+    }
+    case FrameType::PackedDelta: {
+        if (size < header_size + 6)
+            return 0;
+        const int changed = qPopulationCount(get16(data + header_size + 3));
+        const int width = quint8(data[header_size + 5]);
+        if (count > max_channels || width > 32)
+            return -1;
+        return packed_delta_overhead + (changed * width + 7) / 8;
+    }
+    case FrameType::Telemetry:
+        return header_size + count + crc_size;
+    }
+    return -1;
+}
+
+bool checkCrc(const char *data, int frameSize)
+{
+    return frameSize >= crc_size && checkFrame(data, frameSize, frameSize);
+}
+
+int telemetryRecordSize(quint8 record)
+{
+    switch (TelemetryRecord(record)) {
+    case TelemetryRecord::Battery:
+        return 5;
+    case TelemetryRecord::Attitude:
+        return 6;
+    case TelemetryRecord::LinkStats:
+        return 2;
+    }
+    return -1;
+}
+
+int fitResolution(int channelCount, int preferred, int maxSize)
+{
+    for (int bits = qBound(min_resolution, preferred, max_resolution); bits >= min_resolution;
+         --bits) {
+        if (packedKeyframeSize(channelCount, bits) <= maxSize)
+            return bits;
+    }
+    return 0;
+}
+
+qint16 quantize(qint16 value, int resolution)
+{
+    return fromLevel(toLevel(value, resolution), resolution);
+}
+
+quint8 peekType(const char *data, qsizetype size)
+{
+    if (size < encodedSize(0) || quint8(data[0]) != sync_byte
+        || (quint8(data[1]) >> 4) != version)
+        return 0;
+    return quint8(data[1]) & 0x0F;
+}
+
+quint16 crc16(const char *data, qsizetype size, quint16 crc)
+{
+    for (qsizetype i = 0; i < size; ++i)
+        crc = quint16((crc << 8) ^ crc_table[quint8((crc >> 8) ^ quint8(data[i]))]);
+    return crc;
+}
+
+int encode(const ChannelFrame &frame, char *out)
+{
+    const int count = qBound(0, frame.channelCount, max_channels);
+    putHeader(frame, count, out);
+
+    char *channel = out + header_size;
+    for (int i = 0; i < count; ++i, channel += sizeof(qint16))
+        put16(channel, quint16(frame.channels[i]));
+
+    return finish(out, encodedSize(count));
+}
+
+bool decode(const char *data, qsizetype size, ChannelFrame &frame)
+{
+    switch (FrameType(peekType(data, size))) {
+    case FrameType::Channels:
+    case FrameType::Ack:
+    case FrameType::Ping:
+    case FrameType::Pong:
+        break;
+    default:
+        return false;
+    }
+
+    const int count = quint8(data[8]);
+    if (count > max_channels || !checkFrame(data, size, encodedSize(count)))
+        return false;
+
+    frame.type = FrameType(quint8(data[1]) & 0x0F);
+    frame.sequence = get16(data + 2);
+    frame.timestamp = get32(data + 4);
+    frame.channelCount = count;
+
+    const char *channel = data + header_size;
+    for (int i = 0; i < count; ++i, channel += sizeof(qint16))
+        frame.channels[i] = qint16(get16(channel));
+    return true;
+}
+
+int encodeAck(quint16 sequence, quint32 timestamp, char *out)
+{
+    ChannelFrame ack;
+    ack.type = FrameType::Ack;
+    ack.sequence = sequence;
+    ack.timestamp = timestamp;
+    return encode(ack, out);
+}
+
+int encodeTelemetry(const ChannelFrame &header, const char *payload, int payloadSize, char *out)
+{
+    payloadSize = qBound(0, payloadSize, max_telemetry_payload);
+    ChannelFrame telemetry = header;
+    telemetry.type = FrameType::Telemetry;
+    putHeader(telemetry, payloadSize, out);
+    std::copy_n(payload, payloadSize, out + header_size);
+    return finish(out, header_size + payloadSize + crc_size);
+}
+
+bool decodeTelemetry(const char *data,
+                     qsizetype size,
+                     ChannelFrame &header,
+                     const char *&payload,
+                     int &payloadSize)
+{
+    if (peekType(data, size) != quint8(FrameType::Telemetry))
+        return false;
+
+    const int length = quint8(data[8]);
+    if (!checkFrame(data, size, header_size + length + crc_size))
+        return false;
+
+    header.type = FrameType::Telemetry;
+    header.sequence = get16(data + 2);
+    header.timestamp = get32(data + 4);
+    header.channelCount = 0;
+    payload = data + header_size;
+    payloadSize = length;
+    return true;
+}
+
+int encodePackedKeyframe(const ChannelFrame &frame, char *out)
+{
+    const int count = qBound(0, frame.channelCount, max_channels);
+    const int bits = frame.resolution;
+    const int size = packedKeyframeSize(count, bits);
+    std::fill_n(out, size, 0);
+
+    ChannelFrame header = frame;
+    header.type = FrameType::PackedKeyframe;
+    putHeader(header, count, out);
+    out[header_size] = char(bits);
+
+    BitWriter writer(out + header_size + 1);
+    for (int i = 0; i < count; ++i)
+        writer.write(toLevel(frame.channels[i], bits), bits);
+    writer.flush();
+
+    return finish(out, size);
+}
+
+int encodePackedDelta(const ChannelFrame &frame,
+                      const ChannelFrame &keyframe,
+                      char *out,
+                      int maxSize)
+{
+    const int count = qBound(0, frame.channelCount, max_channels);
+    const int bits = keyframe.resolution;
+    if (count != keyframe.channelCount)
+        return 0;
+
+    std::array<quint32, max_channels> deltas;
+    quint16 mask = 0;
+    int changed = 0;
+    int width = 0;
+    for (int i = 0; i < count; ++i) {
+        const int delta = int(toLevel(frame.channels[i], bits))
+                          - int(toLevel(keyframe.channels[i], bits));
+        if (!delta)
+            continue;
+        mask |= quint16(1u << i);
+        deltas[changed++] = zigzag(delta);
+        width = qMax(width, bitWidth(zigzag(delta)));
+    }
+
+    const int size = packed_delta_overhead + (changed * width + 7) / 8;
+    if (size > maxSize || size >= packedKeyframeSize(count, bits))
+        return 0;
+
+    std::fill_n(out, size, 0);
+    ChannelFrame header = frame;
+    header.type = FrameType::PackedDelta;
+    putHeader(header, count, out);
+    put16(out + header_size, keyframe.sequence);
+    out[header_size + 2] = char(bits);
+    put16(out + header_size + 3, mask);
+    out[header_size + 5] = char(width);
+
+    BitWriter writer(out + header_size + 6);
+    for (int i = 0; i < changed; ++i)
+        writer.write(deltas[i], width);
+    writer.flush();
+
+    return finish(out, size);
+}
+
+bool decodePacked(const char *data,
+                  qsizetype size,
+                  const ChannelFrame *keyframe,
+                  ChannelFrame &frame)
+{
+    const quint8 type = peekType(data, size);
+    const int count = type ? quint8(data[8]) : 0;
+    if (count > max_channels)
+        return false;
+
+    if (type == quint8(FrameType::PackedKeyframe)) {
+        const int bits = quint8(data[header_size]);
+        if (bits < min_resolution || bits > max_resolution
+            || !checkFrame(data, size, packedKeyframeSize(count, bits)))
+            return false;
+
+        BitReader reader(data + header_size + 1);
+        for (int i = 0; i < count; ++i)
+            frame.channels[i] = fromLevel(reader.read(bits), bits);
+        frame.resolution = bits;
+        frame.keyframeSequence = get16(data + 2);
+    } else if (type == quint8(FrameType::PackedDelta)) {
+        if (size < packed_delta_overhead)
+            return false;
+
+        const int bits = quint8(data[header_size + 2]);
+        const quint16 mask = get16(data + header_size + 3);
+        const int width = quint8(data[header_size + 5]);
+        const int changed = qPopulationCount(mask);
+        if (!keyframe || keyframe->sequence != get16(data + header_size)
+            || keyframe->resolution != bits || keyframe->channelCount != count || width > 32
+            || !checkFrame(data, size, packed_delta_overhead + (changed * width + 7) / 8))
+            return false;
+
+        BitReader reader(data + header_size + 6);
+        for (int i = 0; i < count; ++i) {
+            int level = int(toLevel(keyframe->channels[i], bits));
+            if (mask & (1u << i))
+                level += unzigzag(reader.read(width));
+            frame.channels[i] = fromLevel(quint32(level), bits);
+        }
+        frame.resolution = bits;
+        frame.keyframeSequence = keyframe->sequence;
+    } else {
+        return false;
+    }
+
+    frame.type = FrameType(type);
+    frame.sequence = get16(data + 2);
+    frame.timestamp = get32(data + 4);
+    frame.channelCount = count;
+    return true;
+}
+
+} // namespace ControlProtocol
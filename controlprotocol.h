@@ -0,0 +1,143 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+
+#include <QtGlobal>
+
+#include <array>
+
+// Wire format between the app and the vehicle, version 1. All multi-byte
+// fields are little endian.
+//
+//   0      sync byte 0xA5
+//   1      protocol version (high nibble) | frame type (low nibble)
+//   2..3   sequence number, wraps
+//   4..7   sender timestamp in microseconds, wraps
+//   8      channel count
+//   9..    channel values, int16 each
+//   last 2 CRC-16/CCITT-FALSE over everything before it
+//
+// Packed frames replace the int16 channel values with channels quantised to
+// `resolution` bits and bit-packed LSB first:
+//
+//   PackedKeyframe  header | resolution | packed channels | CRC
+//   PackedDelta     header | keyframe sequence (2) | resolution | changed
+//                   channel mask (2) | delta width | zigzag deltas against
+//                   the keyframe for the masked channels | CRC
+//
+// The receiver answers keyframes it stored with an Ack frame (no channels,
+// sequence = keyframe sequence) and deltas are only ever sent against an
+// acknowledged keyframe.
+//
+// Telemetry frames from the vehicle reuse byte 8 as the payload length; the
+// payload is a list of records, each a TelemetryRecord id followed by its
+// fixed size body:
+//
+//   Battery    uint16 millivolts, int16 centiamps, uint8 remaining percent
+//   Attitude   int16 roll, pitch, yaw in centidegrees
+//   LinkStats  int8 RSSI in dBm, uint8 link quality percent
+//
+// Ping frames (no channels) are answered by the vehicle with a Pong frame
+// carrying the same sequence number and timestamp.
+namespace ControlProtocol {
+
+constexpr quint8 sync_byte = 0xA5;
+constexpr quint8 version = 1;
+constexpr int header_size = 9;
+constexpr int crc_size = 2;
+constexpr int max_channels = 16;
+
+constexpr int min_resolution = 4;
+constexpr int max_resolution = 16;
+constexpr int packed_keyframe_overhead = header_size + 1 + crc_size;
+constexpr int packed_delta_overhead = header_size + 2 + 1 + 2 + 1 + crc_size;
+
+enum class FrameType : quint8 {
+    Channels = 0x1,
+    PackedKeyframe = 0x2,
+    PackedDelta = 0x3,
+    Ack = 0x4,
+    Telemetry = 0x5,
+    Ping = 0x6,
+    Pong = 0x7,
+};
+
+enum class TelemetryRecord : quint8 {
+    Battery = 0x1,
+    Attitude = 0x2,
+    LinkStats = 0x3,
+};
+
+constexpr int max_telemetry_payload = 255;
+
+struct ChannelFrame
+{
+    FrameType type = FrameType::Channels;
+    quint16 sequence = 0;
+    quint32 timestamp = 0;
+    int channelCount = 0;
+    std::array<qint16, max_channels> channels{};
+    // packed frames only
+    int resolution = max_resolution;
+    quint16 keyframeSequence = 0;
+};
+
+constexpr int encodedSize(int channelCount)
+{
+    return header_size + channelCount * int(sizeof(qint16)) + crc_size;
+}
+
+constexpr int packedKeyframeSize(int channelCount, int resolution)
+{
+    return packed_keyframe_overhead + (channelCount * resolution + 7) / 8;
+}
+
+// highest resolution up to preferred whose keyframe fits into maxSize bytes,
+// 0 if not even min_resolution does
+int fitResolution(int channelCount, int preferred, int maxSize);
+// the value a receiver reconstructs from a channel sent at resolution bits
+qint16 quantize(qint16 value, int resolution);
+
+// frame type of a frame with a valid sync byte and version, 0 otherwise
+quint8 peekType(const char *data, qsizetype size);
+// total size of the frame starting at data, 0 if more bytes are needed to
+// tell, -1 if data does not start with a frame header
+int frameSize(const char *data, qsizetype size);
+// CRC check of a complete frame of frameSize bytes
+bool checkCrc(const char *data, int frameSize);
+// size of a telemetry record body, -1 for unknown records
+int telemetryRecordSize(quint8 record);
+
+quint16 crc16(const char *data, qsizetype size, quint16 crc = 0xFFFF);
+
+// out must hold encodedSize(frame.channelCount) bytes, returns bytes written
+int encode(const ChannelFrame &frame, char *out);
+// false on a short, foreign, newer or corrupted frame
+bool decode(const char *data, qsizetype size, ChannelFrame &frame);
+
+int encodeAck(quint16 sequence, quint32 timestamp, char *out);
+
+// out must hold packedKeyframeSize(frame.channelCount, frame.resolution)
+int encodePackedKeyframe(const ChannelFrame &frame, char *out);
+// returns 0 when the delta would not be smaller than maxSize
+int encodePackedDelta(const ChannelFrame &frame,
+                      const ChannelFrame &keyframe,
+                      char *out,
+                      int maxSize);
+int encodeTelemetry(const ChannelFrame &header, const char *payload, int payloadSize, char *out);
+// payload points into data on success
+bool decodeTelemetry(const char *data,
+                     qsizetype size,
+                     ChannelFrame &header,
+                     const char *&payload,
+                     int &payloadSize);
+
+// keyframe is required for PackedDelta frames and must match
+// frame.keyframeSequence
+bool decodePacked(const char *data,
+                  qsizetype size,
+                  const ChannelFrame *keyframe,
+                  ChannelFrame &frame);
+
+} // namespace ControlProtocol
+
+#endif // CONTROLPROTOCOL_H
@@ -19,17 +19,53 @@
 
 #include <QBluetoothUuid>
 
+#include <blelinkconnector.h>
+#include <blelinktransport.h>
+#include <framescheduler.h>
 #include <controllerobject.h>
+#include <eventtrace.h>
+#include <inputtrace.h>
 
 using namespace Qt::StringLiterals;
 
 namespace {
-const QBluetoothUuid service_uuid("{6e400001-b5a3-f393-e0a9-e50e24dcca9e}");
-const QBluetoothUuid rx_uuid("{6e400003-b5a3-f393-e0a9-e50e24dcca9e}");
-const QBluetoothUuid tx_uuid("{6e400002-b5a3-f393-e0a9-e50e24dcca9e}");
+constexpr int devices_flush_interval_ms = 250;
+constexpr int reconnect_initial_delay_ms = 250;
+constexpr int reconnect_max_delay_ms = 8000;
+
+QLowEnergyConnectionParameters profileParameters(Device::ConnectionProfile profile)
+{
+    QLowEnergyConnectionParameters parameters;
+    if (profile == Device::LowLatencyProfile) {
+        // 7.5 ms is the shortest interval BLE allows, most centrals grant 11.25 or 15
+        parameters.setIntervalRange(7.5, 15);
+        parameters.setLatency(0);
+        parameters.setSupervisionTimeout(2000);
+    } else {
+        parameters.setIntervalRange(30, 50);
+        parameters.setLatency(0);
+        parameters.setSupervisionTimeout(4000);
+    }
+    return parameters;
+}
+
+// runs call on the thread context lives in and waits for it
+template<typename Functor>
+void callOn(QObject *context, Functor call)
+{
+    if (context->thread() == QThread::currentThread())
+        call();
+    else
+        QMetaObject::invokeMethod(context, call, Qt::BlockingQueuedConnection);
+}
 }
 Device::Device()
 {
+    m_bluetooth_thread.setObjectName(u"Bluetooth"_s);
+    m_bluetooth_thread.start(QThread::HighPriority);
+    m_bluetooth_context = new QObject;
+    m_bluetooth_context->moveToThread(&m_bluetooth_thread);
+
     //! [les-devicediscovery-1]
     discoveryAgent = new QBluetoothDeviceDiscoveryAgent(this);
     discoveryAgent->setLowEnergyDiscoveryTimeout(25000);
@@ -43,33 +79,107 @@ Device::Device()
             this, &Device::deviceScanFinished);
     //! [les-devicediscovery-1]
 
+    m_devices = new DeviceListModel(this);
+    m_services = new ServiceListModel(this);
+    m_characteristics = new CharacteristicListModel(this);
+
+    m_devices_flush_timer.setSingleShot(true);
+    m_devices_flush_timer.setInterval(devices_flush_interval_ms);
+    connect(&m_devices_flush_timer, &QTimer::timeout, this, [this]() { m_devices->flush(); });
+
+    m_reconnect_timer.setSingleShot(true);
+    connect(&m_reconnect_timer, &QTimer::timeout, this, &Device::startConnection);
+
     setUpdate(u"Search"_s);
 
-    m_controler_object = new ControllerObject(this);
-    connect(m_controler_object, &ControllerObject::dataUpdated, this, &Device::writeData);
+    // clocks the primary vehicle together with the ones added later
+    m_vehicles = new LinkScheduler(this);
+    m_controler_object = new ControllerObject(m_vehicles->clock(), this);
+    m_primary_link = new VehicleLink(u"Primary"_s, m_controler_object);
+    m_vehicles->addLink(m_primary_link);
+    connect(m_controler_object,
+            &ControllerObject::dataUpdated,
+            this,
+            &Device::writeData,
+            Qt::DirectConnection);
+
+    m_telemetry = new TelemetryPipeline(this);
+    connect(m_telemetry,
+            &TelemetryPipeline::keyframeAcknowledged,
+            m_controler_object,
+            &ControllerObject::acknowledgeKeyframe,
+            Qt::DirectConnection);
+
+    m_recorder = new FlightRecorder(this);
+    m_controler_object->setRecorder(m_recorder);
+    // replays into a controller and link of its own
+    m_replay = new FlightReplay(this);
+    // replayed notifications take the same path as live ones, but never
+    // next to a live link: the pipeline has a single producer and its
+    // keyframe acks go to the live controller
+    connect(
+        m_replay,
+        &FlightReplay::rxReplayed,
+        m_telemetry,
+        [this](const QByteArray &data) {
+            QMutexLocker locker(&m_transport_mutex);
+            if (!m_transport)
+                m_telemetry->push(data);
+        },
+        Qt::DirectConnection);
+
+    // physical sticks, where the platform has them. Started from the
+    // controller page, reading grabs every joystick on the system.
+    m_gamepad = new GamepadInput(m_controler_object, this);
+
+    m_latency_probe = new LatencyProbe(this);
+    // Ping frames only make sense to receivers of ControlProtocol
+    auto updateProbeAvailable = [this]() {
+        m_latency_probe->setAvailable(m_controler_object->frameFormat()
+                                      != ControllerObject::RawFormat);
+    };
+    connect(m_controler_object, &ControllerObject::frameFormatChanged, this, updateProbeAvailable);
+    updateProbeAvailable();
+    connect(m_latency_probe, &LatencyProbe::probeReady, this, &Device::writeMessage);
+    connect(m_telemetry,
+            &TelemetryPipeline::pongReceived,
+            m_latency_probe,
+            &LatencyProbe::pongReceived,
+            Qt::DirectConnection);
 }
 
 Device::~Device()
 {
-    qDeleteAll(devices);
-    qDeleteAll(m_services);
-    qDeleteAll(m_characteristics);
-    devices.clear();
-    m_services.clear();
-    m_characteristics.clear();
+    // no frames while the controller and transport go away
+    m_vehicles->clock()->stop();
+
+    LinkTransport *transport = nullptr;
+    {
+        QMutexLocker locker(&m_transport_mutex);
+        transport = std::exchange(m_transport, nullptr);
+    }
+    if (transport && transport->thread() != thread())
+        transport->deleteLater();
+    if (controller)
+        controller->deleteLater();
+    m_bluetooth_context->deleteLater();
+
+    // pending deferred deletes still run when the thread finishes
+    m_bluetooth_thread.quit();
+    m_bluetooth_thread.wait();
 }
 
 void Device::startDeviceDiscovery()
 {
-    qDeleteAll(devices);
-    devices.clear();
-    emit devicesUpdated();
+    m_devices->clear();
+    m_devices_flush_timer.stop();
 
     //! [les-devicediscovery-2]
     discoveryAgent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
     //! [les-devicediscovery-2]
 
     if (discoveryAgent->isActive()) {
+        EVENT_TRACE_ASYNC_BEGIN("discovery", "deviceScan", quintptr(this));
         setUpdate(u"Stop"_s);
         m_deviceScanState = true;
         Q_EMIT stateChanged();
@@ -85,47 +195,56 @@ void Device::stopDeviceDiscovery()
 //! [les-devicediscovery-3]
 void Device::addDevice(const QBluetoothDeviceInfo &info)
 {
-    if (info.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration) {
-        auto devInfo = new DeviceInfo(info);
-        auto it = std::find_if(devices.begin(), devices.end(),
-                               [devInfo](DeviceInfo *dev) {
-                                   return devInfo->getAddress() == dev->getAddress();
-                               });
-        if (it == devices.end()) {
-            devices.append(devInfo);
-        } else {
-            auto oldDev = *it;
-            *it = devInfo;
-            delete oldDev;
-        }
-        emit devicesUpdated();
-    }
+    EVENT_TRACE_SCOPE("discovery", "addDevice");
+    if (!(info.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration))
+        return;
+
+    if (m_devices->update(info))
+        scheduleDevicesFlush();
 }
 //! [les-devicediscovery-3]
 
+void Device::scheduleDevicesFlush()
+{
+    if (!m_devices_flush_timer.isActive())
+        m_devices_flush_timer.start();
+}
+
+void Device::flushDevices()
+{
+    if (!m_devices_flush_timer.isActive())
+        return;
+
+    m_devices_flush_timer.stop();
+    m_devices->flush();
+}
+
 void Device::deviceScanFinished()
 {
+    EVENT_TRACE_SCOPE("discovery", "deviceScanFinished");
+    EVENT_TRACE_ASYNC_END("discovery", "deviceScan", quintptr(this));
+    flushDevices();
     m_deviceScanState = false;
     emit stateChanged();
-    if (devices.isEmpty())
+    if (m_devices->rowCount() == 0)
         setUpdate(u"No Low Energy devices found..."_s);
     else
         setUpdate(u"Done! Scan Again!"_s);
 }
 
-QVariant Device::getDevices()
+DeviceListModel *Device::getDevices() const
 {
-    return QVariant::fromValue(devices);
+    return m_devices;
 }
 
-QVariant Device::getServices()
+ServiceListModel *Device::getServices() const
 {
-    return QVariant::fromValue(m_services);
+    return m_services;
 }
 
-QVariant Device::getCharacteristics()
+CharacteristicListModel *Device::getCharacteristics() const
 {
-    return QVariant::fromValue(m_characteristics);
+    return m_characteristics;
 }
 
 QString Device::getUpdate()
@@ -137,39 +256,56 @@ void Device::scanServices(const QString &address)
 {
     // We need the current device for service discovery.
 
-    for (auto d: std::as_const(devices)) {
-        if (auto device = qobject_cast<DeviceInfo *>(d)) {
-            if (device->getAddress() == address) {
-                currentDevice.setDevice(device->getDevice());
-                break;
-            }
-        }
-    }
+    const QBluetoothDeviceInfo device = m_devices->device(address);
+    if (device.isValid())
+        currentDevice.setDevice(device);
 
     if (!currentDevice.getDevice().isValid()) {
         qWarning() << "Not a valid device";
         return;
     }
 
-    qDeleteAll(m_characteristics);
-    m_characteristics.clear();
-    emit characteristicsUpdated();
-    qDeleteAll(m_services);
-    m_services.clear();
-    emit servicesUpdated();
+    m_auto_reconnect = true;
+    m_reconnect_attempt = 0;
+    m_reconnect_timer.stop();
+    m_link_down_clock.invalidate();
+    startConnection();
+}
+
+void Device::startConnection()
+{
+    EVENT_TRACE_SCOPE("connection", "startConnection");
+    setConnectionState(Connecting);
+    setTransport(nullptr);
+
+    if (m_connection_interval > 0) {
+        m_connection_interval = 0;
+        m_primary_link->setLinkInterval(0);
+        emit connectionParametersChanged();
+    }
+    m_rx_tx_service = nullptr;
+    m_characteristics->clear();
+    m_services->clear();
+    setDiscovering(true);
+
+    m_connect_clock.start();
+    m_cached_layout = m_gatt_cache.find(currentDevice.getAddress());
 
     setUpdate(u"Back\n(Connecting to device...)"_s);
 
     if (controller && m_previousAddress != currentDevice.getAddress()) {
-        controller->disconnectFromDevice();
-        delete controller;
+        controller->disconnect(this);
+        QMetaObject::invokeMethod(controller, &QLowEnergyController::disconnectFromDevice);
+        controller->deleteLater();
         controller = nullptr;
     }
 
     //! [les-controller-1]
     if (!controller) {
+        const QBluetoothDeviceInfo info = currentDevice.getDevice();
+        callOn(m_bluetooth_context,
+               [this, &info]() { controller = QLowEnergyController::createCentral(info); });
         // Connecting signals and slots for connecting to LE services.
-        controller = QLowEnergyController::createCentral(currentDevice.getDevice(), this);
         connect(controller, &QLowEnergyController::connected,
                 this, &Device::deviceConnected);
         connect(controller, &QLowEnergyController::errorOccurred, this, &Device::errorReceived);
@@ -179,13 +315,17 @@ void Device::scanServices(const QString &address)
                 this, &Device::addLowEnergyService);
         connect(controller, &QLowEnergyController::discoveryFinished,
                 this, &Device::serviceScanDone);
+        connect(controller, &QLowEnergyController::connectionUpdated,
+                this, &Device::connectionParametersUpdated);
     }
 
-    if (isRandomAddress())
-        controller->setRemoteAddressType(QLowEnergyController::RandomAddress);
-    else
-        controller->setRemoteAddressType(QLowEnergyController::PublicAddress);
-    controller->connectToDevice();
+    const QLowEnergyController::RemoteAddressType addressType
+        = isRandomAddress() ? QLowEnergyController::RandomAddress
+                            : QLowEnergyController::PublicAddress;
+    QMetaObject::invokeMethod(controller, [central = controller, addressType]() {
+        central->setRemoteAddressType(addressType);
+        central->connectToDevice();
+    });
     //! [les-controller-1]
 
     m_previousAddress = currentDevice.getAddress();
@@ -193,11 +333,17 @@ void Device::scanServices(const QString &address)
 
 void Device::addLowEnergyService(const QBluetoothUuid &serviceUuid)
 {
-    if (serviceUuid != service_uuid)
+    EVENT_TRACE_SCOPE("connection", "addLowEnergyService");
+    const QBluetoothUuid expected = m_cached_layout ? m_cached_layout->service
+                                                    : NordicUart::service_uuid;
+    if (serviceUuid != expected)
         return;
 
     //! [les-service-1]
-    QLowEnergyService *service = controller->createServiceObject(serviceUuid);
+    QLowEnergyService *service = nullptr;
+    // a child of the controller, created on its thread
+    callOn(controller,
+           [&]() { service = controller->createServiceObject(serviceUuid, controller); });
     if (!service) {
         qWarning() << "Cannot create service for uuid";
         return;
@@ -205,127 +351,133 @@ void Device::addLowEnergyService(const QBluetoothUuid &serviceUuid)
 
     // filter servicec here based on type
     //! [les-service-1]
-    auto serv = new ServiceInfo(service);
-    m_services.append(serv);
-    emit servicesUpdated();
+    m_services->append(new ServiceInfo(service));
+
+    // known vehicle, no need to wait for the rest of the service discovery
+    if (m_cached_layout)
+        connectToService(m_services->first()->getUuid());
 }
 //! [les-service-1]
 
 void Device::serviceScanDone()
 {
+    EVENT_TRACE_SCOPE("connection", "serviceScanDone");
     setUpdate(u"\n(Service scan done!)"_s);
     // force UI in case we didn't find anything
-    if (m_services.isEmpty()) {
+    if (m_services->isEmpty()) {
+        if (m_cached_layout) {
+            // stale, do a full discovery next time
+            m_gatt_cache.remove(currentDevice.getAddress());
+            m_cached_layout.reset();
+        }
         setUpdate(u"\n(Could not find the right service)"_s);
-        emit servicesUpdated();
-    } else {
-        connectToService(m_services.first()->getUuid());
+        setDiscovering(false);
+    } else if (!m_rx_tx_service) {
+        connectToService(m_services->first()->getUuid());
     }
 }
 
 void Device::connectToService(const QString &uuid)
 {
-    QLowEnergyService *service = nullptr;
-    for (auto s: std::as_const(m_services)) {
-        auto serviceInfo = qobject_cast<ServiceInfo *>(s);
-        if (!serviceInfo)
-            continue;
-
-        if (serviceInfo->getUuid() == uuid) {
-            service = serviceInfo->service();
-            break;
-        }
+    EVENT_TRACE_SCOPE("connection", "connectToService");
+    ServiceInfo *serviceInfo = m_services->find(uuid);
+    QLowEnergyService *service = serviceInfo ? serviceInfo->service() : nullptr;
+    if (!service) {
+        m_rx_tx_service = nullptr;
+        return;
     }
 
-    m_rx_tx_service = service;
-    if (!m_rx_tx_service)
+    // the service lives on the Bluetooth thread
+    QLowEnergyService::ServiceState state = QLowEnergyService::InvalidService;
+    QList<QLowEnergyCharacteristic> chars;
+    callOn(service, [&]() {
+        state = service->state();
+        if (state == QLowEnergyService::RemoteServiceDiscovered)
+            chars = service->characteristics();
+    });
+
+    // already started right after discovery
+    if (service == m_rx_tx_service && state == QLowEnergyService::RemoteServiceDiscovering)
         return;
 
+    m_rx_tx_service = service;
+
+#ifdef REMOTE_CONTROL_APP_TRACING
     connect(m_rx_tx_service,
-            &QLowEnergyService::characteristicChanged,
+            &QLowEnergyService::stateChanged,
             this,
-            [this](const QLowEnergyCharacteristic &ch, const QByteArray &data) {
-                if (ch.uuid() == rx_uuid) {
-                    qDebug() << "DATA REC = " << data;
-                }
+            [](QLowEnergyService::ServiceState newState) {
+                EVENT_TRACE_COUNTER("connection", "serviceState", newState);
             });
+    // the notification subscriptions of the RX/TX characteristics
+    connect(m_rx_tx_service,
+            &QLowEnergyService::descriptorWritten,
+            this,
+            []() { EVENT_TRACE_INSTANT("connection", "descriptorWritten"); });
+#endif
+
+    m_characteristics->clear();
+    setDiscovering(true);
 
-    // connect(m_rx_tx_service,
-    //         &QLowEnergyService::stateChanged,
-    //         this,
-    //         [this](QLowEnergyService::ServiceState newState) {
-    //             qDebug() << "SANJAY new State = " << newState;
-    //         });
-
-    // connect(m_rx_tx_service,
-    //         &QLowEnergyService::characteristicRead,
-    //         this,
-    //         [this](const QLowEnergyCharacteristic &info, const QByteArray &value) {
-    //             qDebug() << "SANJAY Ch read = " << info.uuid() << " value = " << value;
-    //         });
-
-    // connect(m_rx_tx_service,
-    //         &QLowEnergyService::characteristicWritten,
-    //         this,
-    //         [this](const QLowEnergyCharacteristic &info, const QByteArray &value) {
-    //             qDebug() << "SANJAY Ch written = " << info.uuid() << " value = " << value;
-    //         });
-
-    // connect(m_rx_tx_service,
-    //         &QLowEnergyService::descriptorWritten,
-    //         this,
-    //         [this](const QLowEnergyDescriptor &info, const QByteArray &value) {
-    //             qDebug() << "SANJAY ds written = " << info.uuid() << " value = " << value;
-    //         });
-
-    // connect(m_rx_tx_service,
-    //         &QLowEnergyService::descriptorRead,
-    //         this,
-    //         [this](const QLowEnergyDescriptor &info, const QByteArray &value) {
-    //             qDebug() << "SANJAY ds read = " << info.uuid() << " value = " << value;
-    //         });
-
-    qDeleteAll(m_characteristics);
-    m_characteristics.clear();
-    emit characteristicsUpdated();
-
-    if (m_rx_tx_service->state() == QLowEnergyService::RemoteService) {
+    if (state == QLowEnergyService::RemoteService) {
         //! [les-service-3]
         connect(m_rx_tx_service,
                 &QLowEnergyService::stateChanged,
                 this,
                 &Device::serviceDetailsDiscovered);
-        m_rx_tx_service->discoverDetails();
+        // the values of the RX/TX characteristics are meaningless, a known
+        // vehicle skips reading them
+        const QLowEnergyService::DiscoveryMode mode = m_cached_layout
+                                                          ? QLowEnergyService::SkipValueDiscovery
+                                                          : QLowEnergyService::FullDiscovery;
+        QMetaObject::invokeMethod(m_rx_tx_service, [service = m_rx_tx_service, mode]() {
+            service->discoverDetails(mode);
+        });
         setUpdate(u"Back\n(Discovering details...)"_s);
+        setConnectionState(DiscoveringDetails);
         //! [les-service-3]
         return;
     }
 
     //discovery already done
-    const QList<QLowEnergyCharacteristic> chars = m_rx_tx_service->characteristics();
-    for (const QLowEnergyCharacteristic &ch : chars) {
-        auto cInfo = new CharacteristicInfo(ch);
-        m_characteristics.append(cInfo);
-    }
+    for (const QLowEnergyCharacteristic &ch : chars)
+        m_characteristics->append(new CharacteristicInfo(ch));
 
-    QTimer::singleShot(0, this, &Device::characteristicsUpdated);
+    setDiscovering(false);
 }
 
 void Device::deviceConnected()
 {
+    EVENT_TRACE_SCOPE("connection", "deviceConnected");
     setUpdate(u"Back\n(Discovering services...)"_s);
     connected = true;
+    setConnectionState(DiscoveringServices);
     emit currentDeviceChanged();
 
     //! [les-service-2]
-    controller->discoverServices();
+    QMetaObject::invokeMethod(controller, &QLowEnergyController::discoverServices);
     //! [les-service-2]
 }
 
 void Device::errorReceived(QLowEnergyController::Error /*error*/)
 {
-    qWarning() << "Error: " << controller->errorString();
-    setUpdate(u"Back\n(%1)"_s.arg(controller->errorString()));
+    EVENT_TRACE_INSTANT("connection", "errorReceived");
+    if (!controller)
+        return;
+
+    QString errorString;
+    QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
+    callOn(controller, [&]() {
+        errorString = controller->errorString();
+        state = controller->state();
+    });
+    qWarning() << "Error: " << errorString;
+    setUpdate(u"Back\n(%1)"_s.arg(errorString));
+    setDiscovering(false);
+
+    // a failed connect attempt does not emit disconnected()
+    if (m_auto_reconnect && state == QLowEnergyController::UnconnectedState)
+        scheduleReconnect();
 }
 
 void Device::setUpdate(const QString &message)
@@ -336,13 +488,17 @@ void Device::setUpdate(const QString &message)
 
 void Device::disconnectFromDevice()
 {
-    // UI always expects disconnect() signal when calling this signal
-    // TODO what is really needed is to extend state() to a multi value
-    // and thus allowing UI to keep track of controller progress in addition to
-    // device scan progress
-
-    if (controller->state() != QLowEnergyController::UnconnectedState)
-        controller->disconnectFromDevice();
+    // UI always expects disconnect() signal when calling this signal,
+    // connectionState tracks the controller progress
+    m_auto_reconnect = false;
+    m_reconnect_timer.stop();
+    m_link_down_clock.invalidate();
+
+    QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
+    if (controller)
+        callOn(controller, [&]() { state = controller->state(); });
+    if (state != QLowEnergyController::UnconnectedState)
+        QMetaObject::invokeMethod(controller, &QLowEnergyController::disconnectFromDevice);
     else
         deviceDisconnected();
 
@@ -350,24 +506,168 @@ void Device::disconnectFromDevice()
     emit rxTxConnectionChanged();
 }
 
+void Device::addVehicle(const QString &address)
+{
+    const QBluetoothDeviceInfo info = m_devices->device(address);
+    if (!info.isValid()) {
+        qWarning() << "Not a valid device";
+        return;
+    }
+
+    const QLowEnergyController::RemoteAddressType addressType
+        = isRandomAddress() ? QLowEnergyController::RandomAddress
+                            : QLowEnergyController::PublicAddress;
+    auto connector = new BleLinkConnector(info, addressType, m_bluetooth_context, this);
+    connect(connector,
+            &BleLinkConnector::connected,
+            this,
+            [this, connector](BleLinkTransport *transport) {
+                auto link = new VehicleLink(connector->name(), transport, m_vehicles->clock());
+                // addLink() deletes the link and its transport when no slot is left
+                if (!m_vehicles->addLink(link)) {
+                    qWarning() << "No room for vehicle" << connector->name();
+                    connector->deleteLater();
+                    return;
+                }
+                // reconnects the vehicle for as long as the link exists
+                connector->setParent(link);
+            });
+    connect(connector, &BleLinkConnector::failed, connector, &QObject::deleteLater);
+    connector->start();
+}
+
 void Device::deviceDisconnected()
 {
+    EVENT_TRACE_INSTANT("connection", "deviceDisconnected");
     qWarning() << "Disconnect from device";
     connected = false;
+    setDiscovering(false);
+
+    if (m_auto_reconnect) {
+        if (m_connection_state == Connected) {
+            ++m_link_drops;
+            m_link_down_clock.start();
+            emit linkMetricsChanged();
+        }
+        scheduleReconnect();
+        return;
+    }
+
+    setConnectionState(Disconnected);
     emit disconnected();
 }
 
+void Device::scheduleReconnect()
+{
+    if (m_reconnect_timer.isActive())
+        return;
+
+    const int delay = qMin(reconnect_initial_delay_ms << qMin(m_reconnect_attempt, 5),
+                           reconnect_max_delay_ms);
+    ++m_reconnect_attempt;
+    setConnectionState(WaitingToReconnect);
+    setUpdate(u"Back\n(Reconnecting in %1 ms...)"_s.arg(delay));
+    m_reconnect_timer.start(delay);
+}
+
+Device::ConnectionProfile Device::connectionProfile() const
+{
+    return m_connection_profile;
+}
+
+void Device::setConnectionProfile(ConnectionProfile profile)
+{
+    if (m_connection_profile == profile)
+        return;
+
+    m_connection_profile = profile;
+    // there is no request that hands the choice back to the central, the
+    // parameters of the previous profile stay until the link is rebuilt
+    m_connection_profile_pending = m_connection_state == Connected && profile == DefaultProfile;
+    if (m_connection_profile_pending)
+        qInfo() << "Default connection parameters apply after reconnecting";
+    emit connectionProfileChanged();
+    if (m_connection_state == Connected)
+        requestConnectionParameters();
+}
+
+bool Device::isConnectionProfilePending() const
+{
+    return m_connection_profile_pending;
+}
+
+double Device::connectionInterval() const
+{
+    return m_connection_interval;
+}
+
+int Device::peripheralLatency() const
+{
+    return m_peripheral_latency;
+}
+
+int Device::supervisionTimeout() const
+{
+    return m_supervision_timeout;
+}
+
+void Device::requestConnectionParameters()
+{
+    if (!controller || m_connection_profile == DefaultProfile)
+        return;
+
+    QMetaObject::invokeMethod(controller,
+                              [central = controller,
+                               parameters = profileParameters(m_connection_profile)]() {
+                                  central->requestConnectionUpdate(parameters);
+                              });
+}
+
+void Device::connectionParametersUpdated(const QLowEnergyConnectionParameters &parameters)
+{
+    // the granted interval is reported as a range of one value
+    m_connection_interval = parameters.minimumInterval();
+    m_peripheral_latency = parameters.latency();
+    m_supervision_timeout = parameters.supervisionTimeout();
+    qInfo() << "Connection interval" << m_connection_interval << "ms, latency"
+            << m_peripheral_latency << ", supervision timeout" << m_supervision_timeout << "ms";
+
+    // send on the connection events instead of batching frames between
+    // them, the transport follows the controller by itself. The shared clock
+    // only takes the interval while this is the only vehicle.
+    m_primary_link->setLinkInterval(qRound(m_connection_interval * 1000));
+
+    emit connectionParametersChanged();
+}
+
+Device::ConnectionState Device::connectionState() const
+{
+    return m_connection_state;
+}
+
+void Device::setConnectionState(ConnectionState state)
+{
+    if (m_connection_state == state)
+        return;
+
+    // one async slice per state, shows where a slow connect spends its time
+    static const QMetaEnum states = QMetaEnum::fromType<ConnectionState>();
+    if (m_connection_state != Disconnected)
+        EVENT_TRACE_ASYNC_END("connection", states.valueToKey(m_connection_state), quintptr(this));
+    m_connection_state = state;
+    if (m_connection_state != Disconnected)
+        EVENT_TRACE_ASYNC_BEGIN("connection", states.valueToKey(m_connection_state), quintptr(this));
+    emit connectionStateChanged();
+}
+
 void Device::serviceDetailsDiscovered(QLowEnergyService::ServiceState newState)
 {
+    EVENT_TRACE_SCOPE("connection", "serviceDetailsDiscovered");
     if (newState != QLowEnergyService::RemoteServiceDiscovered) {
         // do not hang in "Scanning for characteristics" mode forever
         // in case the service discovery failed
-        // We have to queue the signal up to give UI time to even enter
-        // the above mode
-        if (newState != QLowEnergyService::RemoteServiceDiscovering) {
-            QMetaObject::invokeMethod(this, "characteristicsUpdated",
-                                      Qt::QueuedConnection);
-        }
+        if (newState != QLowEnergyService::RemoteServiceDiscovering)
+            setDiscovering(false);
         return;
     }
 
@@ -377,51 +677,134 @@ void Device::serviceDetailsDiscovered(QLowEnergyService::ServiceState newState)
     }
 
     //! [les-chars]
-    const QList<QLowEnergyCharacteristic> chars = service->characteristics();
+    QLowEnergyCharacteristic rxCharacteristic;
+    QList<QLowEnergyCharacteristic> chars;
+    GattCache::Layout layout;
+    callOn(service, [&]() {
+        chars = service->characteristics();
+        layout.service = service->serviceUuid();
+        const QLowEnergyCharacteristic tx = service->characteristic(NordicUart::tx_uuid);
+        const QLowEnergyCharacteristic rx = service->characteristic(NordicUart::rx_uuid);
+        layout.tx = tx.uuid();
+        layout.txProperties = tx.properties();
+        layout.rx = rx.uuid();
+        layout.rxProperties = rx.properties();
+        layout.rxNotifiable = rx.clientCharacteristicConfiguration().isValid();
+    });
+
+    if (m_cached_layout && !(layout == *m_cached_layout)) {
+        discoverWithoutCache();
+        return;
+    }
+
     for (const QLowEnergyCharacteristic &ch : chars) {
-        if (ch.uuid() == tx_uuid || ch.uuid() == rx_uuid) {
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.append(cInfo);
+        if (ch.uuid() == NordicUart::tx_uuid || ch.uuid() == NordicUart::rx_uuid) {
+            m_characteristics->append(new CharacteristicInfo(ch));
 
-            if (ch.uuid() == tx_uuid) {
-                m_tx_characteric = m_characteristics.last()->getCharacteristic();
+            if (ch.uuid() == NordicUart::tx_uuid) {
+                m_tx_characteric = ch;
+            } else {
+                rxCharacteristic = ch;
             }
         }
     }
     //! [les-chars]
 
-    if (m_characteristics.size() != 2) {
+    if (m_characteristics->size() != 2) {
         setUpdate("Missing Rx or Tx characterstics");
     } else {
-        for (CharacteristicInfo *characteristicInfo : m_characteristics) {
-            auto characteristic = characteristicInfo->getCharacteristic();
-            auto m_notificationDesc = characteristic.descriptor(
-                QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
-            if (m_notificationDesc.isValid()) {
-                m_rx_tx_service->writeDescriptor(m_notificationDesc, QByteArray::fromHex("0100"));
-            }
+        for (qsizetype i = 0; i < m_characteristics->size(); ++i) {
+            auto characteristic = m_characteristics->at(i)->getCharacteristic();
+            // the descriptors are read on the service's thread too
+            QMetaObject::invokeMethod(m_rx_tx_service,
+                                      [service = m_rx_tx_service, characteristic]() {
+                                          const QLowEnergyDescriptor notificationDesc
+                                              = characteristic.descriptor(
+                                                  QBluetoothUuid::DescriptorType::
+                                                      ClientCharacteristicConfiguration);
+                                          if (notificationDesc.isValid())
+                                              service->writeDescriptor(notificationDesc,
+                                                                       QByteArray::fromHex("0100"));
+                                      });
         }
 
-        // actual connected
-        emit rxTxConnectionChanged();
+        // actual connected, the transport flushes on the Bluetooth thread
+        BleLinkTransport *transport = nullptr;
+        callOn(m_bluetooth_context, [&]() {
+            transport = new BleLinkTransport(controller,
+                                             m_rx_tx_service,
+                                             m_tx_characteric,
+                                             rxCharacteristic);
+        });
+        setTransport(transport);
+        m_gatt_cache.store(currentDevice.getAddress(), layout);
+        recordTimeToControl();
+        setConnectionState(Connected);
+        m_reconnect_attempt = 0;
+        if (m_connection_profile_pending) {
+            m_connection_profile_pending = false;
+            emit connectionProfileChanged();
+        }
+        requestConnectionParameters();
+
+        if (m_link_down_clock.isValid()) {
+            m_last_link_down_time = int(m_link_down_clock.elapsed());
+            m_longest_link_down_time = qMax(m_longest_link_down_time, m_last_link_down_time);
+            m_last_reconnect_time = m_time_to_control;
+            m_link_down_clock.invalidate();
+            qInfo() << "Link restored after" << m_last_link_down_time << "ms";
+            emit linkMetricsChanged();
+        }
     }
-    emit characteristicsUpdated();
+    setDiscovering(false);
 }
 
-void Device::writeData(QByteArray data)
+void Device::discoverWithoutCache()
 {
-    if (connected && m_rx_tx_service && controller
-        && controller->state() == QLowEnergyController::DiscoveredState) {
-        if (m_tx_characteric.isValid()) {
-            m_rx_tx_service->writeCharacteristic(m_tx_characteric,
-                                                 data,
-                                                 QLowEnergyService::WriteMode::WriteWithoutResponse);
-        }
+    qInfo() << "Cached GATT layout of" << currentDevice.getAddress() << "is stale";
+    m_gatt_cache.remove(currentDevice.getAddress());
+    m_cached_layout.reset();
+
+    // a discovered service cannot discover again, start over on a new one
+    m_rx_tx_service = nullptr;
+    m_characteristics->clear();
+    m_services->clear();
+    QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
+    callOn(controller, [&]() { state = controller->state(); });
+    addLowEnergyService(NordicUart::service_uuid);
+    // otherwise serviceScanDone() connects to it
+    if (state == QLowEnergyController::DiscoveredState)
+        serviceScanDone();
+}
+
+void Device::writeData(const QByteArray &data)
+{
+    EVENT_TRACE_SCOPE("frame", "writeData");
+    QMutexLocker locker(&m_transport_mutex);
+    if (m_transport) {
+        InputTrace::mark(InputTrace::WireDispatch, InputTrace::current());
+        m_transport->write(data);
     }
+    if (m_recorder->isRecording())
+        m_recorder->recordData(FlightLog::Frame, data);
+}
+
+void Device::writeMessage(const QByteArray &data)
+{
+    QMutexLocker locker(&m_transport_mutex);
+    if (m_transport)
+        m_transport->write(data, WriteQueue::Message);
+}
+
+void Device::linkMtuChanged()
+{
+    if (m_transport)
+        m_controler_object->setMaxFrameSize(m_transport->mtu() - 3);
 }
 
 void Device::deviceScanError(QBluetoothDeviceDiscoveryAgent::Error error)
 {
+    EVENT_TRACE_ASYNC_END("discovery", "deviceScan", quintptr(this));
     if (error == QBluetoothDeviceDiscoveryAgent::PoweredOffError) {
         setUpdate(u"The Bluetooth adaptor is powered off, power it on before doing discovery."_s);
     } else if (error == QBluetoothDeviceDiscoveryAgent::InputOutputError) {
@@ -441,9 +824,28 @@ bool Device::state()
     return m_deviceScanState;
 }
 
+bool Device::isDiscovering() const
+{
+    return m_discovering;
+}
+
+void Device::setDiscovering(bool discovering)
+{
+    if (m_discovering == discovering)
+        return;
+
+    m_discovering = discovering;
+    emit discoveringChanged();
+}
+
 bool Device::hasControllerError() const
 {
-    return (controller && controller->error() != QLowEnergyController::NoError);
+    if (!controller)
+        return false;
+
+    QLowEnergyController::Error error = QLowEnergyController::NoError;
+    callOn(controller, [&]() { error = controller->error(); });
+    return error != QLowEnergyController::NoError;
 }
 
 bool Device::isRandomAddress() const
@@ -459,7 +861,7 @@ void Device::setRandomAddress(bool newValue)
 
 bool Device::rxTxConnected() const
 {
-    return connected && m_characteristics.size() == 2;
+    return m_transport && m_transport->isReady();
 }
 
 QString Device::connectedDeviceName() const
@@ -471,3 +873,85 @@ QString Device::connectedDeviceId() const
 {
     return currentDevice.getAddress();
 }
+
+void Device::setEventTracing(bool enabled)
+{
+    EventTrace::setEnabled(enabled);
+}
+
+bool Device::writeEventTrace(const QString &path)
+{
+    return EventTrace::writeJson(path);
+}
+
+void Device::recordTimeToControl()
+{
+    if (!m_connect_clock.isValid())
+        return;
+
+    m_time_to_control = int(m_connect_clock.elapsed());
+    m_connected_from_cache = m_cached_layout.has_value();
+    if (m_connected_from_cache)
+        m_cached_time_to_control = m_time_to_control;
+    else
+        m_full_time_to_control = m_time_to_control;
+    m_connect_clock.invalidate();
+
+    qInfo() << "Time to control" << m_time_to_control << "ms"
+            << (m_connected_from_cache ? "(cached layout)" : "(full discovery)");
+    emit connectTimingChanged();
+}
+
+LinkTransport *Device::transport() const
+{
+    return m_transport;
+}
+
+void Device::setTransport(LinkTransport *transport)
+{
+    if (m_transport == transport)
+        return;
+
+    // before the old transport may be freed on the Bluetooth thread
+    m_primary_link->setTransport(transport);
+    LinkTransport *previous = nullptr;
+    {
+        QMutexLocker locker(&m_transport_mutex);
+        previous = std::exchange(m_transport, transport);
+    }
+    // writeData() on the clock thread no longer sees it
+    if (previous) {
+        previous->disconnect();
+        previous->deleteLater();
+    }
+
+    if (m_transport) {
+        // the BLE transport stays on the Bluetooth thread, deleteLater() frees it
+        if (m_transport->thread() == thread())
+            m_transport->setParent(this);
+        connect(m_transport, &LinkTransport::readyChanged, this, &Device::rxTxConnectionChanged);
+        connect(m_transport,
+                &LinkTransport::dataReceived,
+                m_telemetry,
+                &TelemetryPipeline::push,
+                Qt::DirectConnection);
+        connect(
+            m_transport,
+            &LinkTransport::dataReceived,
+            this,
+            [this](const QByteArray &data) { m_recorder->recordData(FlightLog::Rx, data); },
+            Qt::DirectConnection);
+        connect(m_transport, &LinkTransport::mtuChanged, this, &Device::linkMtuChanged);
+        linkMtuChanged();
+        // parameters may have been updated before the transport existed
+        auto ble = qobject_cast<BleLinkTransport *>(m_transport);
+        if (ble && m_connection_interval > 0)
+            ble->setConnectionInterval(qMax(1, qRound(m_connection_interval)));
+    }
+    m_controler_object->resetEncoder();
+    // the scheduler kept running through the outage, send the current state
+    // with a fresh keyframe right away
+    if (m_transport)
+        m_controler_object->markChanged();
+    emit rxTxConnectionChanged();
+}
@@ -4,21 +4,34 @@
 #ifndef DEVICE_H
 #define DEVICE_H
 
-#include "characteristicinfo.h"
+#include "characteristiclistmodel.h"
+#include "devicelistmodel.h"
 #include "deviceinfo.h"
-#include "serviceinfo.h"
+#include "gattcache.h"
+#include "servicelistmodel.h"
 
 #include <QBluetoothDeviceDiscoveryAgent>
+#include <QLowEnergyConnectionParameters>
 #include <QLowEnergyController>
 #include <QLowEnergyService>
 
-#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QVariant>
 
 #include <QQmlEngine>
+#include <QThread>
 #include <QTimer>
 #include <controllerobject.h>
+#include <flightrecorder.h>
+#include <flightreplay.h>
+#include <gamepadinput.h>
+#include <latencyprobe.h>
+#include <linkscheduler.h>
+#include <telemetrypipeline.h>
+
+class LinkTransport;
 
 QT_BEGIN_NAMESPACE
 class QBluetoothDeviceInfo;
@@ -28,39 +41,109 @@ QT_END_NAMESPACE
 class Device: public QObject
 {
     Q_OBJECT
-    Q_PROPERTY(QVariant devicesList READ getDevices NOTIFY devicesUpdated)
-    Q_PROPERTY(QVariant servicesList READ getServices NOTIFY servicesUpdated)
-    Q_PROPERTY(QVariant characteristicList READ getCharacteristics NOTIFY characteristicsUpdated)
+    Q_PROPERTY(DeviceListModel *devicesList READ getDevices CONSTANT)
+    Q_PROPERTY(ServiceListModel *servicesList READ getServices CONSTANT)
+    Q_PROPERTY(CharacteristicListModel *characteristicList READ getCharacteristics CONSTANT)
     Q_PROPERTY(QString update READ getUpdate WRITE setUpdate NOTIFY updateChanged)
     Q_PROPERTY(bool useRandomAddress READ isRandomAddress WRITE setRandomAddress
                NOTIFY randomAddressChanged)
     Q_PROPERTY(bool state READ state NOTIFY stateChanged)
+    // services or characteristics of the connecting device are being discovered
+    Q_PROPERTY(bool discovering READ isDiscovering NOTIFY discoveringChanged)
     Q_PROPERTY(bool controllerError READ hasControllerError)
     Q_PROPERTY(bool rxTxConnected READ rxTxConnected NOTIFY rxTxConnectionChanged)
+    Q_PROPERTY(ConnectionState connectionState READ connectionState NOTIFY connectionStateChanged)
+    Q_PROPERTY(ConnectionProfile connectionProfile READ connectionProfile
+                   WRITE setConnectionProfile NOTIFY connectionProfileChanged)
+    // the central keeps the parameters it granted, the profile applies on
+    // the next connect
+    Q_PROPERTY(bool connectionProfilePending READ isConnectionProfilePending
+                   NOTIFY connectionProfileChanged)
+    // parameters granted by the peripheral, 0 until the first update
+    Q_PROPERTY(double connectionInterval READ connectionInterval NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int peripheralLatency READ peripheralLatency NOTIFY connectionParametersChanged)
+    Q_PROPERTY(int supervisionTimeout READ supervisionTimeout NOTIFY connectionParametersChanged)
     Q_PROPERTY(QString connectedDeviceName READ connectedDeviceName NOTIFY currentDeviceChanged)
     Q_PROPERTY(QString connectedDeviceId READ connectedDeviceId NOTIFY currentDeviceChanged)
     Q_PROPERTY(ControllerObject *controller MEMBER m_controler_object CONSTANT)
+    Q_PROPERTY(TelemetryPipeline *telemetry MEMBER m_telemetry CONSTANT)
+    Q_PROPERTY(LatencyProbe *latencyProbe MEMBER m_latency_probe CONSTANT)
+    // the frame clock of all vehicles, the one connected here comes first
+    Q_PROPERTY(LinkScheduler *vehicles MEMBER m_vehicles CONSTANT)
+    Q_PROPERTY(FlightRecorder *recorder MEMBER m_recorder CONSTANT)
+    Q_PROPERTY(FlightReplay *replay MEMBER m_replay CONSTANT)
+    Q_PROPERTY(GamepadInput *gamepad MEMBER m_gamepad CONSTANT)
+    // milliseconds from scanServices() until the link is ready, -1 if unknown
+    Q_PROPERTY(int timeToControl MEMBER m_time_to_control NOTIFY connectTimingChanged)
+    // whether the last connect took the GATT cache path, and the last time
+    // to control of each path
+    Q_PROPERTY(bool connectedFromCache MEMBER m_connected_from_cache NOTIFY connectTimingChanged)
+    Q_PROPERTY(int cachedTimeToControl MEMBER m_cached_time_to_control NOTIFY connectTimingChanged)
+    Q_PROPERTY(int fullTimeToControl MEMBER m_full_time_to_control NOTIFY connectTimingChanged)
+    // unexpected disconnects and how long the link stayed down, in ms
+    Q_PROPERTY(int linkDrops MEMBER m_link_drops NOTIFY linkMetricsChanged)
+    Q_PROPERTY(int lastLinkDownTime MEMBER m_last_link_down_time NOTIFY linkMetricsChanged)
+    Q_PROPERTY(int longestLinkDownTime MEMBER m_longest_link_down_time NOTIFY linkMetricsChanged)
+    // duration of the connect attempt that brought the link back, in ms
+    Q_PROPERTY(int lastReconnectTime MEMBER m_last_reconnect_time NOTIFY linkMetricsChanged)
 
     QML_ELEMENT
     QML_SINGLETON
 
 public:
+    enum ConnectionState {
+        Disconnected,
+        Connecting,
+        DiscoveringServices,
+        DiscoveringDetails,
+        Connected,
+        // link dropped, the next attempt is scheduled with backoff
+        WaitingToReconnect
+    };
+    Q_ENUM(ConnectionState)
+
+    enum ConnectionProfile {
+        // leave the parameters to the central
+        DefaultProfile,
+        // shortest interval the frame rate can use, no peripheral latency
+        LowLatencyProfile,
+        // slower interval, saves power on both sides
+        BalancedProfile
+    };
+    Q_ENUM(ConnectionProfile)
+
     Device();
     ~Device();
-    QVariant getDevices();
-    QVariant getServices();
-    QVariant getCharacteristics();
+    DeviceListModel *getDevices() const;
+    ServiceListModel *getServices() const;
+    CharacteristicListModel *getCharacteristics() const;
     QString getUpdate();
     bool state();
+    bool isDiscovering() const;
     bool hasControllerError() const;
 
     bool isRandomAddress() const;
     void setRandomAddress(bool newValue);
 
     bool rxTxConnected() const;
+    ConnectionState connectionState() const;
+    ConnectionProfile connectionProfile() const;
+    void setConnectionProfile(ConnectionProfile profile);
+    bool isConnectionProfilePending() const;
+    double connectionInterval() const;
+    int peripheralLatency() const;
+    int supervisionTimeout() const;
     QString connectedDeviceName() const;
     QString connectedDeviceId() const;
 
+    LinkTransport *transport() const;
+    // takes ownership, replaces and deletes the current transport
+    void setTransport(LinkTransport *transport);
+
+    // Chrome trace of discovery, connection, frames and RX, see EventTrace
+    Q_INVOKABLE void setEventTracing(bool enabled);
+    Q_INVOKABLE bool writeEventTrace(const QString &path);
+
 public slots:
     void startDeviceDiscovery();
     void stopDeviceDiscovery();
@@ -68,6 +151,8 @@ public slots:
 
     void connectToService(const QString &uuid);
     void disconnectFromDevice();
+    // connects a discovered device as one more vehicle, see BleLinkConnector
+    void addVehicle(const QString &address);
 
 private slots:
     // QBluetoothDeviceDiscoveryAgent related
@@ -85,35 +170,96 @@ private slots:
     // QLowEnergyService related
     void serviceDetailsDiscovered(QLowEnergyService::ServiceState newState);
 
-    void writeData(QByteArray data);
+    // control frames, latest wins when the link is congested
+    void connectionParametersUpdated(const QLowEnergyConnectionParameters &parameters);
+
+    void writeData(const QByteArray &data);
+    // frames that must not be coalesced, e.g. latency probes
+    void writeMessage(const QByteArray &data);
+    void linkMtuChanged();
 
 Q_SIGNALS:
-    void devicesUpdated();
-    void servicesUpdated();
-    void characteristicsUpdated();
     void updateChanged();
     void stateChanged();
+    void discoveringChanged();
     void disconnected();
     void randomAddressChanged();
     void rxTxConnectionChanged();
     void currentDeviceChanged();
+    void connectTimingChanged();
+    void connectionStateChanged();
+    void linkMetricsChanged();
+    void connectionProfileChanged();
+    void connectionParametersChanged();
 
 private:
     void setUpdate(const QString &message);
+    void scheduleDevicesFlush();
+    void flushDevices();
+    void setDiscovering(bool discovering);
+    void recordTimeToControl();
+    void startConnection();
+    void scheduleReconnect();
+    void setConnectionState(ConnectionState state);
+    void requestConnectionParameters();
+    // drops a stale cache entry and discovers the RX/TX service again in full
+    void discoverWithoutCache();
     QBluetoothDeviceDiscoveryAgent *discoveryAgent;
     DeviceInfo currentDevice;
-    QList<DeviceInfo *> devices;
-    QList<ServiceInfo *> m_services;
-    QList<CharacteristicInfo *> m_characteristics;
+    DeviceListModel *m_devices = nullptr;
+    // coalesces new rows while advertisements stream in
+    QTimer m_devices_flush_timer;
+    ServiceListModel *m_services = nullptr;
+    CharacteristicListModel *m_characteristics = nullptr;
     QString m_previousAddress;
     QString m_message;
     bool connected = false;
+    // the controller, its services and the BLE transport live on this
+    // thread, so radio writes never wait for the GUI event loop
+    QThread m_bluetooth_thread;
+    QObject *m_bluetooth_context = nullptr;
     QLowEnergyController *controller = nullptr;
     bool m_deviceScanState = false;
+    bool m_discovering = false;
     bool randomAddress = false;
     QLowEnergyService *m_rx_tx_service = nullptr;
     QLowEnergyCharacteristic m_tx_characteric;
     ControllerObject *m_controler_object = nullptr;
+    TelemetryPipeline *m_telemetry = nullptr;
+    LatencyProbe *m_latency_probe = nullptr;
+    LinkScheduler *m_vehicles = nullptr;
+    // m_controler_object in the LinkScheduler
+    VehicleLink *m_primary_link = nullptr;
+    FlightRecorder *m_recorder = nullptr;
+    FlightReplay *m_replay = nullptr;
+    GamepadInput *m_gamepad = nullptr;
+    LinkTransport *m_transport = nullptr;
+    GattCache m_gatt_cache;
+    // layout of the device being connected, when it is known from before
+    std::optional<GattCache::Layout> m_cached_layout;
+    QElapsedTimer m_connect_clock;
+    int m_time_to_control = -1;
+    bool m_connected_from_cache = false;
+    int m_cached_time_to_control = -1;
+    int m_full_time_to_control = -1;
+    ConnectionState m_connection_state = Disconnected;
+    // armed by scanServices(), disarmed by disconnectFromDevice()
+    bool m_auto_reconnect = false;
+    int m_reconnect_attempt = 0;
+    QTimer m_reconnect_timer;
+    // runs while an established link is down
+    QElapsedTimer m_link_down_clock;
+    int m_link_drops = 0;
+    int m_last_link_down_time = -1;
+    int m_longest_link_down_time = -1;
+    int m_last_reconnect_time = -1;
+    ConnectionProfile m_connection_profile = LowLatencyProfile;
+    bool m_connection_profile_pending = false;
+    double m_connection_interval = 0;
+    int m_peripheral_latency = 0;
+    int m_supervision_timeout = 0;
+    // writeData() runs on the frame clock thread
+    QMutex m_transport_mutex;
 };
 
 #endif // DEVICE_H
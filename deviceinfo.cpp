@@ -38,6 +38,19 @@ QBluetoothDeviceInfo DeviceInfo::getDevice()
 
 void DeviceInfo::setDevice(const QBluetoothDeviceInfo &dev)
 {
-    device = QBluetoothDeviceInfo(dev);
-    Q_EMIT deviceChanged();
+    // repeated advertisements mostly carry a new RSSI only, which nothing
+    // here displays
+    const bool changed = dev.name() != device.name() || key(dev) != key(device);
+    device = dev;
+    if (changed)
+        Q_EMIT deviceChanged();
+}
+
+DeviceInfo::Key DeviceInfo::key(const QBluetoothDeviceInfo &dev)
+{
+#ifdef Q_OS_DARWIN
+    return dev.deviceUuid();
+#else
+    return dev.address().toUInt64();
+#endif
 }
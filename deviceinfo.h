@@ -9,6 +9,7 @@
 
 #include <QList>
 #include <QObject>
+#include <QUuid>
 
 #include <QQmlEngine>
 
@@ -21,12 +22,20 @@ class DeviceInfo: public QObject
     QML_ANONYMOUS
 
 public:
+#ifdef Q_OS_DARWIN
+    using Key = QUuid;
+#else
+    using Key = quint64;
+#endif
+
     DeviceInfo() = default;
     DeviceInfo(const QBluetoothDeviceInfo &d);
     QString getAddress() const;
     QString getName() const;
     QBluetoothDeviceInfo getDevice();
     void setDevice(const QBluetoothDeviceInfo &dev);
+    // cheap identity for hashing, avoids formatting the address
+    static Key key(const QBluetoothDeviceInfo &dev);
 
 Q_SIGNALS:
     void deviceChanged();
@@ -0,0 +1,91 @@
+#include "devicelistmodel.h"
+
+DeviceListModel::DeviceListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{}
+
+int DeviceListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_visible);
+}
+
+QVariant DeviceListModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid))
+        return QVariant();
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return entry.name;
+    case AddressRole:
+        return entry.address;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> DeviceListModel::roleNames() const
+{
+    return {{NameRole, "deviceName"}, {AddressRole, "deviceAddress"}};
+}
+
+bool DeviceListModel::update(const QBluetoothDeviceInfo &info)
+{
+    const DeviceInfo::Key key = DeviceInfo::key(info);
+    const auto it = m_index.constFind(key);
+    if (it == m_index.cend()) {
+        const DeviceInfo formatted(info);
+        m_index.insert(key, m_entries.size());
+        m_entries.append({info, formatted.getName(), formatted.getAddress()});
+        return true;
+    }
+
+    const qsizetype row = *it;
+    Entry &entry = m_entries[row];
+    entry.info = info;
+    // repeated advertisements mostly carry a new RSSI only, which is not shown
+    if (info.name() == entry.name)
+        return false;
+
+    entry.name = info.name();
+    if (row < m_visible) {
+        const QModelIndex changed = index(int(row));
+        emit dataChanged(changed, changed, {Qt::DisplayRole, NameRole});
+    }
+    return false;
+}
+
+bool DeviceListModel::flush()
+{
+    if (m_visible == m_entries.size())
+        return false;
+
+    beginInsertRows(QModelIndex(), int(m_visible), int(m_entries.size() - 1));
+    m_visible = m_entries.size();
+    endInsertRows();
+    emit countChanged();
+    return true;
+}
+
+void DeviceListModel::clear()
+{
+    if (m_entries.isEmpty())
+        return;
+
+    beginResetModel();
+    m_entries.clear();
+    m_index.clear();
+    m_visible = 0;
+    endResetModel();
+    emit countChanged();
+}
+
+QBluetoothDeviceInfo DeviceListModel::device(const QString &address) const
+{
+    for (qsizetype i = 0; i < m_visible; ++i) {
+        if (m_entries.at(i).address == address)
+            return m_entries.at(i).info;
+    }
+    return QBluetoothDeviceInfo();
+}
@@ -0,0 +1,56 @@
+#ifndef DEVICELISTMODEL_H
+#define DEVICELISTMODEL_H
+
+#include "deviceinfo.h"
+
+#include <QAbstractListModel>
+#include <QBluetoothDeviceInfo>
+#include <QHash>
+#include <QList>
+
+#include <QQmlEngine>
+
+// Discovered devices. New devices are staged and become rows in one batch
+// on flush(), repeated advertisements update the staged or visible entry in
+// place.
+class DeviceListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+    QML_ANONYMOUS
+
+public:
+    enum Roles { NameRole = Qt::UserRole + 1, AddressRole };
+
+    explicit DeviceListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // returns true if the device was not known yet
+    bool update(const QBluetoothDeviceInfo &info);
+    // makes staged devices visible, returns false if there were none
+    bool flush();
+    void clear();
+    QBluetoothDeviceInfo device(const QString &address) const;
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry
+    {
+        QBluetoothDeviceInfo info;
+        QString name;
+        QString address;
+    };
+
+    QList<Entry> m_entries;
+    QHash<DeviceInfo::Key, qsizetype> m_index;
+    // m_entries past this are staged
+    qsizetype m_visible = 0;
+};
+
+#endif // DEVICELISTMODEL_H
@@ -0,0 +1,306 @@
+#include "eventtrace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace Qt::StringLiterals;
+
+namespace EventTrace {
+
+namespace {
+enum Phase : char {
+    Complete = 'X',
+    Instant = 'i',
+    Counter = 'C',
+    AsyncBegin = 'b',
+    AsyncEnd = 'e'
+};
+
+struct Record
+{
+    const char *category;
+    const char *name;
+    qint64 timestamp;
+    // duration of Complete, value of Counter, id of the async phases
+    qint64 value;
+    char phase;
+};
+
+// written by its owning thread only, drained under the registry mutex
+struct ThreadBuffer
+{
+    static constexpr quint32 capacity = 16384;
+
+    std::array<Record, capacity> records;
+    std::atomic<quint32> head{0};
+    std::atomic<quint32> tail{0};
+    std::atomic<quint64> lost{0};
+    int tid = 0;
+    QString name;
+};
+
+struct Event
+{
+    Record record;
+    int tid;
+};
+
+struct Registry
+{
+    static constexpr std::size_t max_events = 1 << 20;
+
+    QMutex mutex;
+    QList<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<Event> events;
+    quint64 lost = 0;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+constexpr int drain_interval_ms = 500;
+
+std::atomic<bool> enabled{false};
+thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+
+QElapsedTimer &clock()
+{
+    static QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+ThreadBuffer &buffer()
+{
+    if (!thread_buffer) {
+        thread_buffer = std::make_shared<ThreadBuffer>();
+        QThread *thread = QThread::currentThread();
+        thread_buffer->name = thread->objectName();
+        if (thread_buffer->name.isEmpty() && QCoreApplication::instance()
+            && thread == QCoreApplication::instance()->thread())
+            thread_buffer->name = u"GUI"_s;
+
+        QMutexLocker locker(&registry().mutex);
+        registry().buffers.append(thread_buffer);
+        thread_buffer->tid = int(registry().buffers.size());
+        if (thread_buffer->name.isEmpty())
+            thread_buffer->name = u"Thread %1"_s.arg(thread_buffer->tid);
+    }
+    return *thread_buffer;
+}
+
+void record(const char *category, const char *name, qint64 timestamp, qint64 value, Phase phase)
+{
+#ifdef REMOTE_CONTROL_APP_TRACING
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+
+    ThreadBuffer &buf = buffer();
+    const quint32 head = buf.head.load(std::memory_order_relaxed);
+    if (head - buf.tail.load(std::memory_order_acquire) >= ThreadBuffer::capacity) {
+        buf.lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buf.records[head % ThreadBuffer::capacity] = {category, name, timestamp, value, phase};
+    buf.head.store(head + 1, std::memory_order_release);
+#else
+    Q_UNUSED(category);
+    Q_UNUSED(name);
+    Q_UNUSED(timestamp);
+    Q_UNUSED(value);
+    Q_UNUSED(phase);
+#endif
+}
+
+// drains the thread buffers, keeps the events when store is true
+void drain(Registry &reg, bool store)
+{
+    for (const auto &buf : std::as_const(reg.buffers)) {
+        const quint32 head = buf->head.load(std::memory_order_acquire);
+        for (quint32 tail = buf->tail.load(std::memory_order_relaxed); tail != head; ++tail) {
+            if (!store)
+                break;
+            if (reg.events.size() >= Registry::max_events) {
+                ++reg.lost;
+                continue;
+            }
+            reg.events.push_back({buf->records[tail % ThreadBuffer::capacity], buf->tid});
+        }
+        buf->tail.store(head, std::memory_order_release);
+        reg.lost += buf->lost.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+QByteArray quoted(const char *text)
+{
+    QByteArray result(text);
+    result.replace('\\', "\\\\").replace('"', "\\\"");
+    for (char &c : result) {
+        if (uchar(c) < 0x20)
+            c = ' ';
+    }
+    return '"' + result + '"';
+}
+
+QByteArray microseconds(qint64 ns)
+{
+    return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+} // namespace
+
+void install(QCoreApplication *app)
+{
+#ifdef REMOTE_CONTROL_APP_TRACING
+    auto timer = new QTimer(app);
+    QObject::connect(timer, &QTimer::timeout, app, []() {
+        if (isEnabled())
+            collect();
+    });
+    timer->start(drain_interval_ms);
+
+    const QString path = qEnvironmentVariable("REMOTE_CONTROL_APP_TRACE");
+    if (path.isEmpty())
+        return;
+
+    setEnabled(true);
+    QObject::connect(app, &QCoreApplication::aboutToQuit, app, [path]() {
+        if (!writeJson(path))
+            qWarning() << "Cannot write trace" << path;
+    });
+#else
+    Q_UNUSED(app);
+#endif
+}
+
+void setEnabled(bool on)
+{
+#ifdef REMOTE_CONTROL_APP_TRACING
+    if (enabled.exchange(on) || !on)
+        return;
+
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    drain(reg, false);
+    reg.events.clear();
+    reg.lost = 0;
+#else
+    Q_UNUSED(on);
+#endif
+}
+
+bool isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+qint64 now()
+{
+    return clock().nsecsElapsed();
+}
+
+void complete(const char *category, const char *name, qint64 start, qint64 end)
+{
+    record(category, name, start, end - start, Complete);
+}
+
+void instant(const char *category, const char *name)
+{
+    record(category, name, now(), 0, Instant);
+}
+
+void counter(const char *category, const char *name, qint64 value)
+{
+    record(category, name, now(), value, Counter);
+}
+
+void asyncBegin(const char *category, const char *name, quint64 id)
+{
+    record(category, name, now(), qint64(id), AsyncBegin);
+}
+
+void asyncEnd(const char *category, const char *name, quint64 id)
+{
+    record(category, name, now(), qint64(id), AsyncEnd);
+}
+
+void collect()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    drain(reg, true);
+}
+
+bool writeJson(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    drain(reg, true);
+
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"lostEvents\":"
+                     + QByteArray::number(reg.lost) + "},\"traceEvents\":[";
+    // the format allows a trailing comma, but not every viewer does
+    const char *separator = "\n";
+    for (const auto &buf : std::as_const(reg.buffers)) {
+        out += separator;
+        separator = ",\n";
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+               + QByteArray::number(buf->tid) + ",\"args\":{\"name\":"
+               + quoted(buf->name.toUtf8().constData()) + "}}";
+    }
+
+    for (const Event &event : reg.events) {
+        const Record &record = event.record;
+        out += separator;
+        separator = ",\n";
+        out += "{\"ph\":\"" + QByteArray(1, record.phase) + "\",\"cat\":" + quoted(record.category)
+               + ",\"name\":" + quoted(record.name) + ",\"ts\":" + microseconds(record.timestamp)
+               + ",\"pid\":1,\"tid\":" + QByteArray::number(event.tid);
+        switch (record.phase) {
+        case Complete:
+            out += ",\"dur\":" + microseconds(record.value);
+            break;
+        case Instant:
+            out += ",\"s\":\"t\"";
+            break;
+        case Counter:
+            out += ",\"args\":{\"value\":" + QByteArray::number(record.value) + '}';
+            break;
+        default:
+            out += ",\"id\":\"0x" + QByteArray::number(quint64(record.value), 16) + '"';
+            break;
+        }
+        out += '}';
+
+        // keeps the buffer small for long traces
+        if (out.size() > (1 << 20)) {
+            file.write(out);
+            out.clear();
+        }
+    }
+    out += "\n]}\n";
+    return file.write(out) == out.size() && file.flush();
+}
+
+} // namespace EventTrace
@@ -0,0 +1,80 @@
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QCoreApplication;
+QT_END_NAMESPACE
+
+// Chrome trace events (chrome://tracing, ui.perfetto.dev) for the discovery,
+// connection, frame and RX paths. Events go into a buffer owned by the
+// recording thread, so recording never takes a lock; a timer on the GUI
+// thread drains the buffers and writeJson() exports everything drained.
+//
+// Use the EVENT_TRACE_* macros, they compile to nothing unless
+// REMOTE_CONTROL_APP_TRACING is defined. Category and name must be string
+// literals or otherwise outlive the trace.
+namespace EventTrace {
+
+// starts the drain timer. REMOTE_CONTROL_APP_TRACE=<file> records from
+// startup and writes the file when the application quits.
+void install(QCoreApplication *app);
+// enabling starts a new trace
+void setEnabled(bool enabled);
+bool isEnabled();
+
+qint64 now();
+
+void complete(const char *category, const char *name, qint64 start, qint64 end);
+void instant(const char *category, const char *name);
+void counter(const char *category, const char *name, qint64 value);
+// spans that start and end in different functions, matched by id
+void asyncBegin(const char *category, const char *name, quint64 id);
+void asyncEnd(const char *category, const char *name, quint64 id);
+
+void collect();
+bool writeJson(const QString &path);
+
+class Scope
+{
+public:
+    Scope(const char *category, const char *name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(isEnabled() ? now() : -1)
+    {}
+    ~Scope()
+    {
+        if (m_start >= 0)
+            complete(m_category, m_name, m_start, now());
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_category;
+    const char *m_name;
+    qint64 m_start;
+};
+
+} // namespace EventTrace
+
+#ifdef REMOTE_CONTROL_APP_TRACING
+#define EVENT_TRACE_CONCAT_(a, b) a##b
+#define EVENT_TRACE_CONCAT(a, b) EVENT_TRACE_CONCAT_(a, b)
+#define EVENT_TRACE_SCOPE(category, name) \
+    const EventTrace::Scope EVENT_TRACE_CONCAT(event_trace_scope_, __LINE__)(category, name)
+#define EVENT_TRACE_INSTANT(category, name) EventTrace::instant(category, name)
+#define EVENT_TRACE_COUNTER(category, name, value) EventTrace::counter(category, name, value)
+#define EVENT_TRACE_ASYNC_BEGIN(category, name, id) EventTrace::asyncBegin(category, name, id)
+#define EVENT_TRACE_ASYNC_END(category, name, id) EventTrace::asyncEnd(category, name, id)
+#else
+#define EVENT_TRACE_SCOPE(category, name) static_cast<void>(0)
+#define EVENT_TRACE_INSTANT(category, name) static_cast<void>(0)
+#define EVENT_TRACE_COUNTER(category, name, value) static_cast<void>(0)
+#define EVENT_TRACE_ASYNC_BEGIN(category, name, id) static_cast<void>(0)
+#define EVENT_TRACE_ASYNC_END(category, name, id) static_cast<void>(0)
+#endif
+
+#endif // EVENTTRACE_H
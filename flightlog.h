@@ -0,0 +1,80 @@
+#ifndef FLIGHTLOG_H
+#define FLIGHTLOG_H
+
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+// On-disk format shared by FlightRecorder and FlightReplay, little-endian:
+//   file header   magic "RCFLOG" u16 version u64 reserved
+//   record header u8 type u8 reserved u16 payload size u64 timestamp (ns)
+//   payload
+namespace FlightLog {
+
+constexpr char magic[6] = {'R', 'C', 'F', 'L', 'O', 'G'};
+constexpr quint16 version = 1;
+constexpr int file_header_size = 16;
+constexpr int record_header_size = 12;
+constexpr int max_payload = 0xFFFF;
+
+enum RecordType : quint8 {
+    // two f64, x and y as passed to the stick slot
+    LeftStick = 1,
+    RightStick = 2,
+    // i32 index, f64 value
+    AuxChannel = 3,
+    // control frame as written to the link
+    Frame = 4,
+    // notification received from the link
+    Rx = 5
+};
+
+struct Record
+{
+    RecordType type;
+    quint64 timestamp;
+    const char *payload;
+    int size;
+};
+
+inline void writeFileHeader(char *out)
+{
+    std::memset(out, 0, file_header_size);
+    std::memcpy(out, magic, sizeof(magic));
+    qToLittleEndian<quint16>(version, out + sizeof(magic));
+}
+
+inline bool checkFileHeader(const char *data, qint64 size)
+{
+    return size >= file_header_size && std::memcmp(data, magic, sizeof(magic)) == 0
+           && qFromLittleEndian<quint16>(data + sizeof(magic)) == version;
+}
+
+inline void writeRecordHeader(char *out, RecordType type, int size, quint64 timestamp)
+{
+    out[0] = char(type);
+    out[1] = 0;
+    qToLittleEndian<quint16>(quint16(size), out + 2);
+    qToLittleEndian<quint64>(timestamp, out + 4);
+}
+
+// returns the offset of the next record, or -1 if the record at offset is
+// truncated
+inline qint64 readRecord(const char *data, qint64 size, qint64 offset, Record &record)
+{
+    if (offset + record_header_size > size)
+        return -1;
+
+    const char *header = data + offset;
+    record.type = RecordType(quint8(header[0]));
+    record.size = qFromLittleEndian<quint16>(header + 2);
+    record.timestamp = qFromLittleEndian<quint64>(header + 4);
+    record.payload = header + record_header_size;
+    const qint64 next = offset + record_header_size + record.size;
+    return next <= size ? next : -1;
+}
+
+} // namespace FlightLog
+
+#endif // FLIGHTLOG_H
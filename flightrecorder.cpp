@@ -0,0 +1,146 @@
+#include "flightrecorder.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <chrono>
+
+namespace {
+constexpr qsizetype buffer_size = 1024 * 1024;
+// flush at least this often so a crash loses little
+constexpr std::chrono::milliseconds flush_interval(100);
+} // namespace
+
+FlightRecorder::FlightRecorder(QObject *parent)
+    : QObject{parent}
+{
+    for (QByteArray &buffer : m_buffers)
+        buffer = QByteArray(buffer_size, Qt::Uninitialized);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    stop();
+}
+
+bool FlightRecorder::start(const QString &path)
+{
+    if (m_thread)
+        return false;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot record to" << path << m_file.errorString();
+        return false;
+    }
+
+    char header[FlightLog::file_header_size];
+    FlightLog::writeFileHeader(header);
+    m_file.write(header, sizeof(header));
+
+    m_written = 0;
+    m_dropped = 0;
+    m_stop = false;
+    m_used = 0;
+    m_clock.start();
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("FlightRecorder");
+    m_thread->start(QThread::LowPriority);
+    m_recording = true;
+    emit recordingChanged();
+    return true;
+}
+
+void FlightRecorder::stop()
+{
+    if (!m_thread)
+        return;
+
+    m_recording = false;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_file.close();
+    emit recordingChanged();
+}
+
+void FlightRecorder::recordStick(FlightLog::RecordType type, double x, double y)
+{
+    char payload[16];
+    qToLittleEndian<double>(x, payload);
+    qToLittleEndian<double>(y, payload + 8);
+    append(type, payload, sizeof(payload));
+}
+
+void FlightRecorder::recordAux(int index, double value)
+{
+    char payload[12];
+    qToLittleEndian<qint32>(index, payload);
+    qToLittleEndian<double>(value, payload + 4);
+    append(FlightLog::AuxChannel, payload, sizeof(payload));
+}
+
+void FlightRecorder::recordData(FlightLog::RecordType type, const QByteArray &data)
+{
+    append(type, data.constData(), int(qMin(data.size(), qsizetype(FlightLog::max_payload))));
+}
+
+void FlightRecorder::append(FlightLog::RecordType type, const char *payload, int size)
+{
+    if (!m_recording.load(std::memory_order_relaxed))
+        return;
+
+    const quint64 timestamp = m_clock.nsecsElapsed();
+    const qsizetype total = FlightLog::record_header_size + size;
+
+    std::unique_lock<std::mutex> locker(m_mutex);
+    if (m_used + total > buffer_size) {
+        m_dropped += total;
+        locker.unlock();
+        m_wake.notify_one();
+        return;
+    }
+
+    char *out = m_buffers[m_active].data() + m_used;
+    FlightLog::writeRecordHeader(out, type, size, timestamp);
+    std::memcpy(out + FlightLog::record_header_size, payload, size);
+    m_used += total;
+    const bool flush = m_used >= buffer_size / 2;
+    locker.unlock();
+
+    if (flush)
+        m_wake.notify_one();
+}
+
+void FlightRecorder::run()
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    for (;;) {
+        m_wake.wait_for(locker, flush_interval, [this]() {
+            return m_stop || m_used >= buffer_size / 2;
+        });
+
+        // hand the filled buffer over and let producers continue in the other one
+        const int filled = m_active;
+        const qsizetype size = m_used;
+        m_active = 1 - m_active;
+        m_used = 0;
+        const bool stop = m_stop;
+        locker.unlock();
+
+        if (size > 0) {
+            m_file.write(m_buffers[filled].constData(), size);
+            m_written += size;
+        }
+        if (stop)
+            break;
+
+        locker.lock();
+    }
+    m_file.flush();
+}
@@ -0,0 +1,68 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+
+#include <flightlog.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// Appends stick inputs, control frames and RX notifications to a binary
+// FlightLog. Recording only copies into one of two preallocated buffers, a
+// background thread writes the other one to disk. If both are full the
+// record is dropped and counted rather than blocking the caller.
+class FlightRecorder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+
+public:
+    explicit FlightRecorder(QObject *parent = nullptr);
+    ~FlightRecorder();
+
+    Q_INVOKABLE bool start(const QString &path);
+    Q_INVOKABLE void stop();
+    bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    // safe to call from any thread, no-ops while not recording
+    void recordStick(FlightLog::RecordType type, double x, double y);
+    void recordAux(int index, double value);
+    void recordData(FlightLog::RecordType type, const QByteArray &data);
+
+    Q_INVOKABLE quint64 writtenBytes() const { return m_written; }
+    Q_INVOKABLE quint64 droppedBytes() const { return m_dropped; }
+
+signals:
+    void recordingChanged();
+
+private:
+    void append(FlightLog::RecordType type, const char *payload, int size);
+    void run();
+
+    QFile m_file;
+    QThread *m_thread = nullptr;
+    QElapsedTimer m_clock;
+    std::atomic<bool> m_recording{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+    std::array<QByteArray, 2> m_buffers;
+    int m_active = 0;
+    qsizetype m_used = 0;
+
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // FLIGHTRECORDER_H
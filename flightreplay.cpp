@@ -0,0 +1,287 @@
+#include "flightreplay.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <controllerobject.h>
+#include <flightlog.h>
+#include <loopbacklinktransport.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace std::chrono;
+
+namespace {
+constexpr int raw_frame_size = 4 * int(sizeof(qint16));
+} // namespace
+
+FlightReplay::FlightReplay(QObject *parent)
+    : QObject{parent}
+{
+    // clocked by the log in lockstep, otherwise by its own scheduler
+    m_controller = new ControllerObject(nullptr, this);
+    // runs on the frame clock thread
+    connect(m_controller->scheduler(),
+            &FrameScheduler::frameDue,
+            m_controller,
+            &ControllerObject::sendFrame,
+            Qt::DirectConnection);
+
+    m_transport = new LoopbackLinkTransport(this);
+    m_transport->setMtu(247);
+    m_transport->setEcho(false);
+    m_controller->setMaxFrameSize(m_transport->mtu() - 3);
+
+    // runs on the replay or the frame clock thread
+    connect(
+        m_controller,
+        &ControllerObject::dataUpdated,
+        this,
+        [this](const QByteArray &data) {
+            if (m_lockstep)
+                compareFrame(data);
+            m_transport->write(data);
+        },
+        Qt::DirectConnection);
+}
+
+FlightReplay::~FlightReplay()
+{
+    close();
+}
+
+bool FlightReplay::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open flight log" << path << m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data || !FlightLog::checkFileHeader(m_data, m_size)) {
+        qWarning() << "Not a flight log" << path;
+        close();
+        return false;
+    }
+
+    // the last complete record tells the length
+    FlightLog::Record record;
+    qint64 offset = FlightLog::file_header_size;
+    m_duration = 0;
+    while ((offset = FlightLog::readRecord(m_data, m_size, offset, record)) > 0)
+        m_duration = record.timestamp;
+
+    emit opened();
+    return true;
+}
+
+void FlightReplay::close()
+{
+    stop();
+    if (m_data)
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    m_data = nullptr;
+    m_size = 0;
+    m_duration = 0;
+    m_file.close();
+}
+
+bool FlightReplay::start()
+{
+    if (m_thread || !m_data)
+        return false;
+
+    // every run starts from the same frame state
+    m_controller->resetFrameState();
+    m_recorded_decoder = {};
+    m_produced_decoder = {};
+    m_has_recorded = false;
+    m_compared = 0;
+    m_mismatched = 0;
+    m_transport->open();
+    // in lockstep the replay thread builds every frame
+    if (!m_lockstep)
+        m_controller->scheduler()->start();
+
+    m_stop = false;
+    m_replayed = 0;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("FlightReplay");
+    connect(m_thread, &QThread::finished, this, [this, run = ++m_run]() {
+        if (run == m_run)
+            replayFinished();
+    });
+    m_thread->start(QThread::HighPriority);
+    emit runningChanged();
+    return true;
+}
+
+void FlightReplay::stop()
+{
+    if (!m_thread)
+        return;
+
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread->wait();
+    replayFinished();
+}
+
+double FlightReplay::speed() const
+{
+    return m_speed;
+}
+
+void FlightReplay::setSpeed(double speed)
+{
+    speed = qMax(speed, 0.0);
+    if (m_speed.exchange(speed) == speed)
+        return;
+
+    emit speedChanged();
+}
+
+bool FlightReplay::lockstep() const
+{
+    return m_lockstep;
+}
+
+void FlightReplay::setLockstep(bool lockstep)
+{
+    if (m_lockstep == lockstep || m_thread)
+        return;
+
+    m_lockstep = lockstep;
+    emit lockstepChanged();
+}
+
+double FlightReplay::duration() const
+{
+    return m_duration / 1e6;
+}
+
+void FlightReplay::run()
+{
+    const steady_clock::time_point started = steady_clock::now();
+    FlightLog::Record record;
+    qint64 offset = FlightLog::file_header_size;
+    qint64 next;
+    while ((next = FlightLog::readRecord(m_data, m_size, offset, record)) > 0) {
+        offset = next;
+
+        const double speed = m_speed;
+        if (speed > 0.0) {
+            const auto due = started + nanoseconds(qint64(record.timestamp / speed));
+            std::unique_lock<std::mutex> locker(m_mutex);
+            if (m_wake.wait_until(locker, due, [this]() { return m_stop; }))
+                return;
+        } else if (m_stop) {
+            return;
+        }
+
+        switch (record.type) {
+        case FlightLog::LeftStick:
+        case FlightLog::RightStick: {
+            if (record.size < 16)
+                break;
+            const double x = qFromLittleEndian<double>(record.payload);
+            const double y = qFromLittleEndian<double>(record.payload + 8);
+            if (record.type == FlightLog::LeftStick)
+                m_controller->leftStickMoved(x, y);
+            else
+                m_controller->rightStickMoved(x, y);
+            break;
+        }
+        case FlightLog::AuxChannel:
+            if (record.size >= 12)
+                m_controller->setAuxChannel(qFromLittleEndian<qint32>(record.payload),
+                                            qFromLittleEndian<double>(record.payload + 4));
+            break;
+        case FlightLog::Frame:
+            emit recordedFrame(QByteArray::fromRawData(record.payload, record.size));
+            if (m_lockstep) {
+                m_has_recorded = m_recorded_decoder.decode(record.payload, record.size, m_recorded);
+                m_controller->sendFrameAt(qint64(record.timestamp));
+            }
+            break;
+        case FlightLog::Rx:
+            emit rxReplayed(QByteArray::fromRawData(record.payload, record.size));
+            break;
+        }
+        ++m_replayed;
+    }
+}
+
+void FlightReplay::compareFrame(const QByteArray &data)
+{
+    ControlProtocol::ChannelFrame produced;
+    if (!m_has_recorded || !m_produced_decoder.decode(data.constData(), data.size(), produced))
+        return;
+
+    ++m_compared;
+    const auto end = produced.channels.begin() + produced.channelCount;
+    if (produced.channelCount != m_recorded.channelCount
+        || !std::equal(produced.channels.begin(), end, m_recorded.channels.begin()))
+        ++m_mismatched;
+}
+
+void FlightReplay::replayFinished()
+{
+    if (!m_thread)
+        return;
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_controller->scheduler()->stop();
+    m_transport->close();
+    if (m_lockstep)
+        qInfo() << "Replay compared" << m_compared << "frames," << m_mismatched << "differed";
+    emit runningChanged();
+    emit finished();
+}
+
+bool FlightReplay::FrameDecoder::decode(const char *data,
+                                        qsizetype size,
+                                        ControlProtocol::ChannelFrame &frame)
+{
+    using ControlProtocol::FrameType;
+    switch (FrameType(ControlProtocol::peekType(data, size))) {
+    case FrameType::Channels:
+        if (ControlProtocol::decode(data, size, frame))
+            return true;
+        break;
+    case FrameType::PackedKeyframe:
+        if (ControlProtocol::decodePacked(data, size, nullptr, frame)) {
+            keyframes[next] = frame;
+            next = (next + 1) % int(keyframes.size());
+            return true;
+        }
+        break;
+    case FrameType::PackedDelta:
+        for (const ControlProtocol::ChannelFrame &keyframe : keyframes) {
+            if (ControlProtocol::decodePacked(data, size, &keyframe, frame))
+                return true;
+        }
+        break;
+    default:
+        break;
+    }
+
+    // RawFormat, the four stick channels without a header
+    if (size != raw_frame_size)
+        return false;
+    frame = {};
+    frame.channelCount = 4;
+    for (int i = 0; i < frame.channelCount; ++i)
+        frame.channels[i] = qFromLittleEndian<qint16>(data + 2 * i);
+    return true;
+}
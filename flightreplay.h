@@ -0,0 +1,117 @@
+#ifndef FLIGHTREPLAY_H
+#define FLIGHTREPLAY_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QObject>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <controlprotocol.h>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+class ControllerObject;
+class LoopbackLinkTransport;
+
+// Plays a FlightLog back into a ControllerObject of its own, whose frames go
+// to a LoopbackLinkTransport. Nothing reaches a live link or the recorder.
+// The log is memory mapped, records are dispatched from a replay thread at
+// the recorded pace scaled by speed, or as fast as possible with speed 0.
+//
+// In lockstep mode a frame is built exactly where the log recorded one, at
+// the recorded time, and both are decoded and compared channel by channel.
+// The bytes differ (header time, sequence, keyframe acks), the channels
+// match as long as controller() is set up like the recording one was.
+class FlightReplay : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double speed READ speed WRITE setSpeed NOTIFY speedChanged)
+    Q_PROPERTY(bool lockstep READ lockstep WRITE setLockstep NOTIFY lockstepChanged)
+    // length of the opened log, milliseconds
+    Q_PROPERTY(double duration READ duration NOTIFY opened)
+    // format, curves, mixer and filter the log is replayed with
+    Q_PROPERTY(ControllerObject *controller READ controller CONSTANT)
+
+public:
+    explicit FlightReplay(QObject *parent = nullptr);
+    ~FlightReplay();
+
+    ControllerObject *controller() const { return m_controller; }
+    LoopbackLinkTransport *transport() const { return m_transport; }
+
+    Q_INVOKABLE bool open(const QString &path);
+    Q_INVOKABLE void close();
+    Q_INVOKABLE bool start();
+    Q_INVOKABLE void stop();
+
+    bool isRunning() const { return m_thread != nullptr; }
+    double speed() const;
+    void setSpeed(double speed);
+    bool lockstep() const;
+    void setLockstep(bool lockstep);
+    double duration() const;
+    Q_INVOKABLE quint64 recordsReplayed() const { return m_replayed; }
+    // lockstep frames whose decoded channels were compared, and how many of
+    // them differed from the recorded frame
+    Q_INVOKABLE quint64 comparedFrames() const { return m_compared; }
+    Q_INVOKABLE quint64 mismatchedFrames() const { return m_mismatched; }
+
+signals:
+    void runningChanged();
+    void speedChanged();
+    void lockstepChanged();
+    void opened();
+    void finished();
+    // emitted on the replay thread, data points into the mapped log and is
+    // only valid during the call
+    void recordedFrame(const QByteArray &data);
+    void rxReplayed(const QByteArray &data);
+
+private:
+    // the channels of any frame format. A packed delta refers to the last
+    // acknowledged keyframe, not always the newest one.
+    struct FrameDecoder
+    {
+        bool decode(const char *data, qsizetype size, ControlProtocol::ChannelFrame &frame);
+
+        std::array<ControlProtocol::ChannelFrame, 8> keyframes{};
+        int next = 0;
+    };
+
+    void run();
+    void compareFrame(const QByteArray &data);
+    void replayFinished();
+
+    ControllerObject *m_controller = nullptr;
+    LoopbackLinkTransport *m_transport = nullptr;
+    QFile m_file;
+    const char *m_data = nullptr;
+    qint64 m_size = 0;
+    quint64 m_duration = 0;
+
+    QThread *m_thread = nullptr;
+    // finished() of an earlier run may still be queued when the next starts
+    quint32 m_run = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+    std::atomic<double> m_speed{1.0};
+    bool m_lockstep = false;
+    std::atomic<quint64> m_replayed{0};
+    // only touched on the replay thread while running
+    FrameDecoder m_recorded_decoder;
+    FrameDecoder m_produced_decoder;
+    ControlProtocol::ChannelFrame m_recorded;
+    bool m_has_recorded = false;
+    std::atomic<quint64> m_compared{0};
+    std::atomic<quint64> m_mismatched{0};
+};
+
+#endif // FLIGHTREPLAY_H
@@ -0,0 +1,26 @@
+#include "framering.h"
+
+FrameRing::FrameRing(int slots, qsizetype capacity)
+    : m_capacity(capacity)
+{
+    m_slots.resize(qMax(slots, 1));
+    for (QByteArray &slot : m_slots)
+        slot.reserve(m_capacity);
+}
+
+QByteArray &FrameRing::acquire(qsizetype size)
+{
+    QByteArray &slot = m_slots[m_next];
+    m_next = (m_next + 1) % m_slots.size();
+
+    if (!slot.isDetached() || slot.capacity() < size) {
+        // still shared with a receiver that is lagging behind, or too small
+        ++m_allocations;
+        m_capacity = qMax(m_capacity, size);
+        slot = QByteArray();
+        slot.reserve(m_capacity);
+    }
+
+    slot.resize(size);
+    return slot;
+}
@@ -0,0 +1,31 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QByteArray>
+#include <QList>
+
+// Fixed set of preallocated frame buffers handed out round robin. A slot is
+// only reallocated when a receiver still holds a reference to it from the
+// previous lap or the frame outgrows the reserved capacity, and every such
+// case is counted in allocations().
+class FrameRing
+{
+public:
+    explicit FrameRing(int slots = 8, qsizetype capacity = 244);
+
+    // next slot resized to size bytes, contents are unspecified
+    QByteArray &acquire(qsizetype size);
+
+    quint64 allocations() const { return m_allocations; }
+    void resetAllocations() { m_allocations = 0; }
+    int slotCount() const { return int(m_slots.size()); }
+    qsizetype capacity() const { return m_capacity; }
+
+private:
+    QList<QByteArray> m_slots;
+    qsizetype m_capacity = 0;
+    int m_next = 0;
+    quint64 m_allocations = 0;
+};
+
+#endif // FRAMERING_H
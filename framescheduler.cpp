@@ -0,0 +1,217 @@
+#include "framescheduler.h"
+
+#include <QThread>
+
+using namespace Qt::StringLiterals;
+using namespace std::chrono;
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject{parent}
+{}
+
+FrameScheduler::~FrameScheduler()
+{
+    stop();
+}
+
+FrameScheduler::Mode FrameScheduler::mode() const
+{
+    return m_mode;
+}
+
+void FrameScheduler::setMode(Mode mode)
+{
+    if (m_mode.exchange(mode) == mode)
+        return;
+
+    wake();
+    emit settingsChanged();
+}
+
+int FrameScheduler::frameInterval() const
+{
+    return m_frame_interval;
+}
+
+void FrameScheduler::setFrameInterval(int msec)
+{
+    m_frame_interval = qMax(msec, 1);
+    wake();
+    emit settingsChanged();
+}
+
+int FrameScheduler::minInterval() const
+{
+    return m_min_interval;
+}
+
+void FrameScheduler::setMinInterval(int msec)
+{
+    m_min_interval = qMax(msec, 0);
+    wake();
+    emit settingsChanged();
+}
+
+int FrameScheduler::heartbeatInterval() const
+{
+    return m_heartbeat_interval;
+}
+
+void FrameScheduler::setHeartbeatInterval(int msec)
+{
+    m_heartbeat_interval = qMax(msec, 1);
+    wake();
+    emit settingsChanged();
+}
+
+void FrameScheduler::setLinkInterval(int usec)
+{
+    m_link_interval = qMax(usec, 0);
+    wake();
+    emit settingsChanged();
+}
+
+int FrameScheduler::linkInterval() const
+{
+    return m_link_interval;
+}
+
+int FrameScheduler::effectiveFrameInterval() const
+{
+    const int frame = m_frame_interval * 1000;
+    const int link = m_link_interval;
+    if (link <= 0)
+        return frame;
+
+    return qMax(1, (frame + link / 2) / link) * link;
+}
+
+void FrameScheduler::start()
+{
+    if (m_thread)
+        return;
+
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_stop = false;
+        m_dirty = true;
+        m_dirty_since = steady_clock::now();
+    }
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName(u"FrameClock"_s);
+    m_thread->start(QThread::TimeCriticalPriority);
+}
+
+void FrameScheduler::stop()
+{
+    if (!m_thread)
+        return;
+
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool FrameScheduler::isActive() const
+{
+    return m_thread;
+}
+
+qint64 FrameScheduler::jitterPercentile(double percent) const
+{
+    return m_jitter.percentile(percent);
+}
+
+void FrameScheduler::resetCounters()
+{
+    m_sent = 0;
+    m_suppressed = 0;
+    m_jitter.reset();
+}
+
+const LatencyHistogram &FrameScheduler::jitterHistogram() const
+{
+    return m_jitter;
+}
+
+void FrameScheduler::markChanged()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (m_dirty) {
+            if (m_mode == OnChange)
+                ++m_suppressed;
+            return;
+        }
+
+        m_dirty = true;
+        m_dirty_since = steady_clock::now();
+        if (m_mode == FixedRate)
+            return;
+
+        m_kicked = true;
+    }
+    m_wake.notify_one();
+}
+
+void FrameScheduler::wake()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_kicked = true;
+    }
+    m_wake.notify_one();
+}
+
+void FrameScheduler::run()
+{
+    std::unique_lock<std::mutex> locker(m_mutex);
+    steady_clock::time_point last_frame = steady_clock::now();
+    steady_clock::time_point next_fixed = last_frame;
+
+    while (!m_stop) {
+        steady_clock::time_point deadline;
+        if (m_mode == FixedRate) {
+            deadline = next_fixed;
+        } else if (m_dirty) {
+            const microseconds min_interval(qMax(m_min_interval * 1000, m_link_interval.load()));
+            deadline = qMax(last_frame + min_interval, m_dirty_since);
+        } else {
+            deadline = last_frame + milliseconds(m_heartbeat_interval);
+        }
+
+        m_kicked = false;
+        m_wake.wait_until(locker, deadline, [this]() { return m_stop || m_kicked; });
+        if (m_stop)
+            break;
+
+        const steady_clock::time_point now = steady_clock::now();
+        if (now < deadline)
+            continue; // settings or input changed, recompute the deadline
+
+        m_jitter.record(duration_cast<microseconds>(now - deadline).count());
+        if (m_mode == FixedRate) {
+            // keep the phase, skip whole periods if we overran
+            const microseconds period(effectiveFrameInterval());
+            next_fixed += period;
+            if (next_fixed <= now)
+                next_fixed = now + period - (now - next_fixed) % period;
+        } else {
+            next_fixed = now;
+        }
+
+        m_dirty = false;
+        last_frame = now;
+        ++m_sent;
+
+        locker.unlock();
+        emit frameDue();
+        locker.lock();
+    }
+}
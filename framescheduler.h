@@ -0,0 +1,103 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+
+#include <latencyhistogram.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// Decides when the next control frame goes out.
+// FixedRate sends every frameInterval, OnChange sends as soon as the input
+// changes (at most once per minInterval) and otherwise only a heartbeat.
+//
+// The clock runs on its own high priority thread and frameDue() is emitted
+// from there, so receivers have to use a direct connection to stay off the
+// GUI thread. How late every frame was against its deadline is recorded in
+// jitterHistogram().
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Mode mode READ mode WRITE setMode NOTIFY settingsChanged)
+    Q_PROPERTY(int frameInterval READ frameInterval WRITE setFrameInterval NOTIFY settingsChanged)
+    Q_PROPERTY(int minInterval READ minInterval WRITE setMinInterval NOTIFY settingsChanged)
+    Q_PROPERTY(int heartbeatInterval READ heartbeatInterval WRITE setHeartbeatInterval
+                   NOTIFY settingsChanged)
+    // follows frameInterval and the link interval, in microseconds
+    Q_PROPERTY(int effectiveFrameInterval READ effectiveFrameInterval NOTIFY settingsChanged)
+
+public:
+    enum Mode { FixedRate, OnChange };
+    Q_ENUM(Mode)
+
+    explicit FrameScheduler(QObject *parent = nullptr);
+    ~FrameScheduler();
+
+    Mode mode() const;
+    void setMode(Mode mode);
+    int frameInterval() const;
+    void setFrameInterval(int msec);
+    int minInterval() const;
+    void setMinInterval(int msec);
+    int heartbeatInterval() const;
+    void setHeartbeatInterval(int msec);
+    // connection interval of the radio link, 0 if unknown. Fixed rate frames
+    // are sent at the multiple of it closest to frameInterval, change driven
+    // frames no faster than once per interval.
+    void setLinkInterval(int usec);
+    int linkInterval() const;
+    // period FixedRate actually uses, in microseconds
+    int effectiveFrameInterval() const;
+
+    void start();
+    void stop();
+    bool isActive() const;
+
+    Q_INVOKABLE quint64 sentFrames() const { return m_sent; }
+    // input changes folded into a frame that was already pending
+    Q_INVOKABLE quint64 suppressedFrames() const { return m_suppressed; }
+    // lateness of the frame clock against its deadline, in microseconds
+    Q_INVOKABLE qint64 jitterPercentile(double percent) const;
+    Q_INVOKABLE void resetCounters();
+
+    const LatencyHistogram &jitterHistogram() const;
+
+public slots:
+    // safe to call from any thread
+    void markChanged();
+
+signals:
+    // emitted on the control thread
+    void frameDue();
+    void settingsChanged();
+
+private:
+    void run();
+    void wake();
+
+    QThread *m_thread = nullptr;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+    bool m_kicked = false;
+    bool m_dirty = false;
+    std::chrono::steady_clock::time_point m_dirty_since;
+
+    std::atomic<Mode> m_mode{FixedRate};
+    std::atomic<int> m_frame_interval{20};
+    std::atomic<int> m_min_interval{10};
+    std::atomic<int> m_heartbeat_interval{100};
+    std::atomic<int> m_link_interval{0};
+    std::atomic<quint64> m_sent{0};
+    std::atomic<quint64> m_suppressed{0};
+    LatencyHistogram m_jitter;
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,678 @@
+#include "gamepadinput.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <channelstate.h>
+#include <controllerobject.h>
+#include <eventtrace.h>
+#include <inputtrace.h>
+#include <responsecurve.h>
+
+#include <algorithm>
+#include <array>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+#define GAMEPADINPUT_EVDEV
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+static_assert(GamepadProfile::axis_count == ABS_CNT);
+static_assert(GamepadProfile::button_count == KEY_CNT);
+#endif
+
+using namespace Qt::StringLiterals;
+
+namespace {
+constexpr auto input_directory = "/dev/input"_L1;
+constexpr int max_epoll_events = 16;
+constexpr int events_per_read = 64;
+// recordings have no device to ask for the range
+constexpr int default_axis_minimum = -32768;
+constexpr int default_axis_maximum = 32767;
+} // namespace
+
+#ifdef GAMEPADINPUT_EVDEV
+namespace {
+qint64 monotonicNow()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+qint64 eventTime(const input_event &event)
+{
+    return qint64(event.input_event_sec) * 1000000000 + qint64(event.input_event_usec) * 1000;
+}
+
+void setEventTime(input_event &event, qint64 ns)
+{
+    event.input_event_sec = ns / 1000000000;
+    event.input_event_usec = (ns % 1000000000) / 1000;
+}
+
+template<std::size_t N>
+bool testBit(const std::array<unsigned long, N> &bits, int bit)
+{
+    constexpr int word = 8 * sizeof(unsigned long);
+    return (bits[bit / word] >> (bit % word)) & 1;
+}
+
+template<int Bits>
+using BitArray = std::array<unsigned long, (Bits + 8 * sizeof(unsigned long) - 1)
+                                               / (8 * sizeof(unsigned long))>;
+} // namespace
+
+struct GamepadInput::Source
+{
+    struct Axis
+    {
+        int channel = -1;
+        float center = 0;
+        float scale = 0;
+    };
+
+    int fd = -1;
+    QString path;
+    QString name;
+    bool device = true;
+    // the kernel dropped events, ignore everything up to the next report
+    bool dropped = false;
+    std::array<Axis, GamepadProfile::axis_count> axes;
+    // values collected since the last SYN_REPORT
+    std::array<qint16, ChannelState::max_channels> values{};
+    quint32 dirty = 0;
+
+    void set(int channel, qint16 value)
+    {
+        values[channel] = value;
+        dirty |= 1u << channel;
+    }
+
+    void setAxis(int code, int raw)
+    {
+        const Axis &axis = axes[code];
+        if (axis.channel < 0)
+            return;
+        const float value = (raw - axis.center) * axis.scale;
+        set(axis.channel,
+            qint16(qBound(-float(ResponseCurve::full_scale), value, float(ResponseCurve::full_scale))));
+    }
+
+    // ranges come from the profile, the device or the evdev default, in that order
+    void configure(const GamepadProfile &profile)
+    {
+        for (int code = 0; code < GamepadProfile::axis_count; ++code) {
+            const GamepadProfile::Mapping &mapping = profile.axes[code];
+            axes[code] = {};
+            if (mapping.channel < 0)
+                continue;
+
+            int minimum = mapping.minimum;
+            int maximum = mapping.maximum;
+            input_absinfo info;
+            if (minimum >= maximum && device && ioctl(fd, EVIOCGABS(code), &info) == 0) {
+                minimum = info.minimum;
+                maximum = info.maximum;
+            }
+            if (minimum >= maximum) {
+                minimum = default_axis_minimum;
+                maximum = default_axis_maximum;
+            }
+
+            const float scale = 2.0f * ResponseCurve::full_scale / (float(maximum) - minimum);
+            axes[code] = {mapping.channel,
+                          (float(minimum) + maximum) / 2,
+                          mapping.inverted ? -scale : scale};
+        }
+    }
+
+    // current state of every mapped axis and button, after opening and
+    // after SYN_DROPPED
+    void resync(const GamepadProfile &profile)
+    {
+        if (!device)
+            return;
+
+        for (int code = 0; code < GamepadProfile::axis_count; ++code) {
+            input_absinfo info;
+            if (axes[code].channel >= 0 && ioctl(fd, EVIOCGABS(code), &info) == 0)
+                setAxis(code, info.value);
+        }
+
+        BitArray<KEY_CNT> keys{};
+        if (ioctl(fd, EVIOCGKEY(sizeof(keys)), keys.data()) < 0)
+            return;
+        for (int code = 0; code < GamepadProfile::button_count; ++code) {
+            const GamepadProfile::Mapping &mapping = profile.buttons[code];
+            if (mapping.channel >= 0)
+                setButton(mapping, testBit(keys, code));
+        }
+    }
+
+    void setButton(const GamepadProfile::Mapping &mapping, bool pressed)
+    {
+        set(mapping.channel,
+            qint16(pressed != mapping.inverted ? ResponseCurve::full_scale
+                                               : -ResponseCurve::full_scale));
+    }
+};
+#else
+struct GamepadInput::Source
+{};
+#endif
+
+GamepadInput::GamepadInput(ControllerObject *controller, QObject *parent)
+    : QObject{parent}
+    , m_controller(controller)
+    , m_profile(GamepadProfile::standard())
+{
+    // runs on the frame clock thread, the frame being sent is the current trace id
+    connect(
+        m_controller,
+        &ControllerObject::dataUpdated,
+        this,
+        [this]() { frameSent(InputTrace::current()); },
+        Qt::DirectConnection);
+}
+
+GamepadInput::~GamepadInput()
+{
+    stop();
+}
+
+bool GamepadInput::isActive() const
+{
+    return m_thread;
+}
+
+QStringList GamepadInput::devices() const
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    return m_device_names;
+}
+
+QString GamepadInput::profile() const
+{
+    return m_profile_path;
+}
+
+void GamepadInput::setProfile(const QString &path)
+{
+    if (m_profile_path == path)
+        return;
+
+    std::optional<GamepadProfile> profile = path.isEmpty() ? GamepadProfile::standard()
+                                                           : GamepadProfile::load(path);
+    if (!profile) {
+        qWarning() << "Cannot load gamepad profile" << path;
+        return;
+    }
+
+    // the reader thread owns the profile while it runs
+    const bool active = isActive();
+    stop();
+    m_profile = *profile;
+    m_profile_path = path;
+    if (active)
+        start();
+    emit profileChanged();
+}
+
+double GamepadInput::eventToStatePercentile(double percent) const
+{
+    return m_event_to_state.percentile(percent) / 1000.0;
+}
+
+double GamepadInput::eventToFramePercentile(double percent) const
+{
+    return m_event_to_frame.percentile(percent) / 1000.0;
+}
+
+const LatencyHistogram &GamepadInput::eventToState() const
+{
+    return m_event_to_state;
+}
+
+const LatencyHistogram &GamepadInput::eventToFrame() const
+{
+    return m_event_to_frame;
+}
+
+void GamepadInput::resetStatistics()
+{
+    m_event_to_state.reset();
+    m_event_to_frame.reset();
+}
+
+void GamepadInput::frameSent(quint32 sequence)
+{
+    quint32 pending = m_pending_sequence.load();
+    if (!pending || qint32(sequence - pending) < 0)
+        return;
+
+    // commit() may replace the pending update meanwhile, then the exchange fails
+    const qint64 event = m_pending_event.load();
+#ifdef GAMEPADINPUT_EVDEV
+    if (m_pending_sequence.compare_exchange_strong(pending, 0))
+        m_event_to_frame.record((monotonicNow() - event) / 1000);
+#else
+    Q_UNUSED(event);
+#endif
+}
+
+#ifdef GAMEPADINPUT_EVDEV
+
+bool GamepadInput::start()
+{
+    if (m_thread)
+        return true;
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wake < 0) {
+        qWarning() << "Cannot start gamepad input:" << strerror(errno);
+        if (m_epoll >= 0)
+            ::close(m_epoll);
+        if (m_wake >= 0)
+            ::close(m_wake);
+        m_epoll = m_wake = -1;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wake;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+
+    // udev fixes the permissions after the node is created
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0
+        && inotify_add_watch(m_inotify, input_directory.latin1(), IN_CREATE | IN_ATTRIB) >= 0) {
+        event.data.fd = m_inotify;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_inotify, &event);
+    }
+
+    m_stop = false;
+    m_thread = QThread::create([this]() {
+        scanDevices();
+        run();
+    });
+    m_thread->setObjectName(u"GamepadInput"_s);
+    m_thread->start(QThread::TimeCriticalPriority);
+    emit activeChanged();
+    return true;
+}
+
+void GamepadInput::stop()
+{
+    if (!m_thread)
+        return;
+
+    m_stop = true;
+    // feeders first, so the reader drains whatever they are blocked on
+    for (QThread *feeder : std::as_const(m_feeders)) {
+        feeder->wait();
+        delete feeder;
+    }
+    m_feeders.clear();
+
+    wake();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    for (const Recording &recording : m_new_recordings)
+        ::close(recording.fd);
+    m_new_recordings.clear();
+    if (m_inotify >= 0)
+        ::close(m_inotify);
+    ::close(m_wake);
+    ::close(m_epoll);
+    m_epoll = m_wake = m_inotify = -1;
+
+    publishDevices();
+    emit activeChanged();
+}
+
+bool GamepadInput::replay(const QString &path, bool paced)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray events = file.readAll();
+    if (events.isEmpty() || events.size() % qsizetype(sizeof(input_event))) {
+        qWarning() << "Not an evdev recording" << path;
+        return false;
+    }
+
+    if (!start())
+        return false;
+
+    // a packet socket keeps events whole and does not raise SIGPIPE
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+        return false;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_new_recordings.push_back({fds[0], QFileInfo(path).fileName()});
+    }
+    wake();
+
+    m_feeders.removeIf([](QThread *feeder) {
+        if (!feeder->isFinished())
+            return false;
+        delete feeder;
+        return true;
+    });
+    QThread *feeder = QThread::create([this, events, fd = fds[1], paced]() {
+        feed(events, fd, paced);
+        ::close(fd);
+    });
+    feeder->setObjectName(u"GamepadReplay"_s);
+    feeder->start();
+    m_feeders.append(feeder);
+    return true;
+}
+
+void GamepadInput::feed(const QByteArray &events, int fd, bool paced)
+{
+    const auto *begin = reinterpret_cast<const input_event *>(events.constData());
+    const auto *end = begin + events.size() / sizeof(input_event);
+    const qint64 recorded_start = eventTime(*begin);
+    const qint64 start = monotonicNow();
+
+    for (const input_event *it = begin; it != end && !m_stop; ++it) {
+        if (paced) {
+            const qint64 due = start + eventTime(*it) - recorded_start;
+            // short naps so stop() does not wait out a long pause in the recording
+            for (qint64 now = monotonicNow(); now < due && !m_stop; now = monotonicNow())
+                std::this_thread::sleep_for(std::chrono::nanoseconds(qMin(due - now, qint64(10000000))));
+        }
+
+        input_event event = *it;
+        setEventTime(event, monotonicNow());
+        ssize_t written;
+        do {
+            written = send(fd, &event, sizeof(event), MSG_NOSIGNAL);
+        } while (written < 0 && errno == EINTR);
+        if (written < 0)
+            return;
+    }
+}
+
+void GamepadInput::wake()
+{
+    const quint64 one = 1;
+    if (m_wake >= 0) {
+        const ssize_t written = ::write(m_wake, &one, sizeof(one));
+        Q_UNUSED(written);
+    }
+}
+
+void GamepadInput::run()
+{
+    std::array<epoll_event, max_epoll_events> events;
+    while (!m_stop) {
+        const int count = epoll_wait(m_epoll, events.data(), max_epoll_events, -1);
+        if (count < 0 && errno != EINTR) {
+            qWarning() << "Gamepad input stopped:" << strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_wake) {
+                quint64 value;
+                const ssize_t size = ::read(m_wake, &value, sizeof(value));
+                Q_UNUSED(size);
+                std::vector<Recording> recordings;
+                {
+                    std::lock_guard<std::mutex> locker(m_mutex);
+                    recordings.swap(m_new_recordings);
+                }
+                for (const Recording &recording : recordings)
+                    openRecording(recording);
+            } else if (fd == m_inotify) {
+                readHotplug();
+            } else {
+                for (const std::unique_ptr<Source> &source : m_sources) {
+                    if (source->fd == fd) {
+                        readSource(source.get());
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    for (const std::unique_ptr<Source> &source : m_sources)
+        ::close(source->fd);
+    m_sources.clear();
+}
+
+void GamepadInput::scanDevices()
+{
+    const QStringList nodes = QDir(input_directory).entryList({u"event*"_s}, QDir::System);
+    for (const QString &node : nodes)
+        openDevice(input_directory + '/'_L1 + node);
+}
+
+void GamepadInput::openDevice(const QString &path)
+{
+    for (const std::unique_ptr<Source> &source : m_sources) {
+        if (source->path == path)
+            return;
+    }
+
+    // without read access (not in the input group) the device is skipped
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    // touchscreens, touchpads and motion sensors report ABS_X as well
+    BitArray<ABS_CNT> axes{};
+    BitArray<INPUT_PROP_CNT> properties{};
+    ioctl(fd, EVIOCGPROP(sizeof(properties)), properties.data());
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(axes)), axes.data()) < 0 || !testBit(axes, ABS_X)
+        || testBit(properties, INPUT_PROP_DIRECT) || testBit(properties, INPUT_PROP_POINTER)
+        || testBit(properties, INPUT_PROP_ACCELEROMETER)) {
+        ::close(fd);
+        return;
+    }
+
+    char name[256] = {};
+    ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+    // timestamps comparable to the frame clock
+    int clock = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock);
+
+    auto source = std::make_unique<Source>();
+    source->fd = fd;
+    source->path = path;
+    source->name = QString::fromLocal8Bit(name);
+    addSource(std::move(source));
+}
+
+void GamepadInput::openRecording(const Recording &recording)
+{
+    auto source = std::make_unique<Source>();
+    source->fd = recording.fd;
+    source->name = recording.name;
+    source->device = false;
+    addSource(std::move(source));
+}
+
+void GamepadInput::addSource(std::unique_ptr<Source> source)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = source->fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, source->fd, &event) < 0) {
+        ::close(source->fd);
+        return;
+    }
+
+    source->configure(m_profile);
+    source->resync(m_profile);
+    // initial positions, not an input event
+    commit(*source, 0);
+    m_sources.push_back(std::move(source));
+    publishDevices();
+}
+
+void GamepadInput::removeSource(Source *source)
+{
+    const bool device = source->device;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, source->fd, nullptr);
+    ::close(source->fd);
+    m_sources.erase(std::find_if(m_sources.begin(),
+                                 m_sources.end(),
+                                 [source](const std::unique_ptr<Source> &s) {
+                                     return s.get() == source;
+                                 }));
+    publishDevices();
+    if (!device)
+        emit replayFinished();
+}
+
+void GamepadInput::readSource(Source *source)
+{
+    std::array<input_event, events_per_read> events;
+    for (;;) {
+        const ssize_t size = ::read(source->fd, events.data(), sizeof(events));
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size < 0 && errno == EAGAIN)
+            return;
+        if (size <= 0) {
+            // unplugged (ENODEV) or the end of a recording
+            removeSource(source);
+            return;
+        }
+
+        const int count = int(size / sizeof(input_event));
+        for (int i = 0; i < count; ++i) {
+            const input_event &event = events[i];
+            switch (event.type) {
+            case EV_ABS:
+                if (!source->dropped && event.code < GamepadProfile::axis_count)
+                    source->setAxis(event.code, event.value);
+                break;
+            case EV_KEY:
+                // 2 is autorepeat
+                if (!source->dropped && event.code < GamepadProfile::button_count
+                    && event.value != 2 && m_profile.buttons[event.code].channel >= 0)
+                    source->setButton(m_profile.buttons[event.code], event.value);
+                break;
+            case EV_SYN:
+                if (event.code == SYN_DROPPED) {
+                    source->dropped = true;
+                } else if (event.code == SYN_REPORT) {
+                    if (source->dropped) {
+                        source->dropped = false;
+                        source->resync(m_profile);
+                    }
+                    commit(*source, eventTime(event));
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+void GamepadInput::readHotplug()
+{
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t size = ::read(m_inotify, buffer, sizeof(buffer));
+        if (size <= 0)
+            return;
+
+        for (const char *it = buffer; it < buffer + size;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(it);
+            const QString node = QString::fromLocal8Bit(event->name);
+            if (event->len && node.startsWith("event"_L1))
+                openDevice(input_directory + '/'_L1 + node);
+            it += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void GamepadInput::commit(Source &source, qint64 eventNs)
+{
+    if (!source.dirty)
+        return;
+
+    EVENT_TRACE_SCOPE("input", "gamepadReport");
+
+    std::array<ChannelState::Update, ChannelState::max_channels> updates;
+    int count = 0;
+    for (int channel = 0; channel < ChannelState::max_channels; ++channel) {
+        if (source.dirty & (1u << channel))
+            updates[count++] = {channel, source.values[channel]};
+    }
+    source.dirty = 0;
+
+    const quint32 sequence = m_controller->setChannels(updates.data(), count);
+    if (!sequence || !eventNs)
+        return;
+
+    m_event_to_state.record((monotonicNow() - eventNs) / 1000);
+    m_pending_sequence = 0;
+    m_pending_event = eventNs;
+    m_pending_sequence = sequence;
+}
+
+#else
+
+bool GamepadInput::start()
+{
+    return false;
+}
+
+void GamepadInput::stop() {}
+
+bool GamepadInput::replay(const QString &, bool)
+{
+    return false;
+}
+
+#endif
+
+void GamepadInput::publishDevices()
+{
+    QStringList names;
+#ifdef GAMEPADINPUT_EVDEV
+    for (const std::unique_ptr<Source> &source : m_sources)
+        names.append(source->name);
+#endif
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (m_device_names == names)
+            return;
+        m_device_names = names;
+    }
+    emit devicesChanged();
+}
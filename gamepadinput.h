@@ -0,0 +1,118 @@
+#ifndef GAMEPADINPUT_H
+#define GAMEPADINPUT_H
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include <gamepadprofile.h>
+#include <latencyhistogram.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+class ControllerObject;
+
+// Gamepads and RC transmitters in joystick mode, read from the Linux evdev
+// interface (/dev/input/event*) on a dedicated epoll thread. Every SYN_REPORT
+// stores the mapped values straight into the ControllerObject, the GUI event
+// loop is not involved. Nothing is opened before start(), then devices are
+// also picked up when they are plugged in. On other platforms there is
+// nothing to read and start() returns false.
+class GamepadInput : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+    Q_PROPERTY(QStringList devices READ devices NOTIFY devicesChanged)
+    // INI file, see GamepadProfile, empty for the standard mapping
+    Q_PROPERTY(QString profile READ profile WRITE setProfile NOTIFY profileChanged)
+
+public:
+    explicit GamepadInput(ControllerObject *controller, QObject *parent = nullptr);
+    ~GamepadInput();
+
+    bool isActive() const;
+    QStringList devices() const;
+    QString profile() const;
+    void setProfile(const QString &path);
+
+    Q_INVOKABLE bool start();
+    Q_INVOKABLE void stop();
+
+    // feeds a raw evdev stream, e.g. `cat /dev/input/event5 > sticks.evdev`,
+    // through the reader thread like a device. paced keeps the recorded
+    // timing; timestamps are rewritten to the moment each event is fed.
+    Q_INVOKABLE bool replay(const QString &path, bool paced = true);
+
+    // kernel event timestamp to ChannelState, and to the first encoded frame
+    // carrying the value, in milliseconds. The touch path is measured by
+    // ControllerObject::inputTraceReport().
+    Q_INVOKABLE double eventToStatePercentile(double percent) const;
+    Q_INVOKABLE double eventToFramePercentile(double percent) const;
+    const LatencyHistogram &eventToState() const;
+    const LatencyHistogram &eventToFrame() const;
+    Q_INVOKABLE void resetStatistics();
+
+signals:
+    void activeChanged();
+    void devicesChanged();
+    void profileChanged();
+    // a replayed stream was fed completely and read back
+    void replayFinished();
+
+private:
+    struct Source;
+    struct Recording
+    {
+        int fd;
+        QString name;
+    };
+
+    // reader thread
+    void run();
+    void scanDevices();
+    void openDevice(const QString &path);
+    void openRecording(const Recording &recording);
+    void addSource(std::unique_ptr<Source> source);
+    void removeSource(Source *source);
+    void readSource(Source *source);
+    void readHotplug();
+    void commit(Source &source, qint64 eventNs);
+    void publishDevices();
+    // frame clock thread
+    void frameSent(quint32 sequence);
+    // feeder threads
+    void feed(const QByteArray &events, int fd, bool paced);
+
+    void wake();
+
+    ControllerObject *m_controller = nullptr;
+    GamepadProfile m_profile;
+    QString m_profile_path;
+    QThread *m_thread = nullptr;
+    QList<QThread *> m_feeders;
+    std::atomic<bool> m_stop{false};
+    int m_epoll = -1;
+    int m_wake = -1;
+    int m_inotify = -1;
+    // only touched by the reader thread
+    std::vector<std::unique_ptr<Source>> m_sources;
+
+    mutable std::mutex m_mutex;
+    QStringList m_device_names;
+    std::vector<Recording> m_new_recordings;
+
+    LatencyHistogram m_event_to_state;
+    LatencyHistogram m_event_to_frame;
+    // newest stored update the frame clock has not sent yet
+    std::atomic<quint32> m_pending_sequence{0};
+    std::atomic<qint64> m_pending_event{0};
+};
+
+#endif // GAMEPADINPUT_H
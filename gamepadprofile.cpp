@@ -0,0 +1,128 @@
+#include "gamepadprofile.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+
+#include <channelstate.h>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+enum Channel { Roll = 0, Pitch = 1, Throttle = 2, Yaw = 3, StickChannelCount = 4 };
+
+// linux/input-event-codes.h, kept here so profiles build everywhere
+enum Code {
+    AbsX = 0x00,
+    AbsY = 0x01,
+    AbsRx = 0x03,
+    AbsRy = 0x04,
+    BtnSouth = 0x130,
+    BtnEast = 0x131,
+    BtnNorth = 0x133,
+    BtnWest = 0x134
+};
+
+int channelFromName(const QString &name)
+{
+    static const QLatin1StringView sticks[StickChannelCount] = {"roll"_L1, "pitch"_L1,
+                                                                 "throttle"_L1, "yaw"_L1};
+    for (int i = 0; i < StickChannelCount; ++i) {
+        if (name == sticks[i])
+            return i;
+    }
+
+    if (!name.startsWith("aux"_L1))
+        return -1;
+
+    bool ok = false;
+    const int channel = StickChannelCount + name.mid(3).toInt(&ok) - 1;
+    return ok && channel >= StickChannelCount && channel < ChannelState::max_channels ? channel
+                                                                                      : -1;
+}
+
+// "[-]channel[, minimum, maximum]"
+std::optional<GamepadProfile::Mapping> parseMapping(const QStringList &fields)
+{
+    if (fields.size() != 1 && fields.size() != 3)
+        return std::nullopt;
+
+    GamepadProfile::Mapping mapping;
+    QString channel = fields.first().trimmed().toLower();
+    if (channel.startsWith('-'_L1)) {
+        mapping.inverted = true;
+        channel.remove(0, 1);
+    }
+    mapping.channel = channelFromName(channel);
+    if (mapping.channel < 0)
+        return std::nullopt;
+
+    if (fields.size() == 3) {
+        bool min_ok = false;
+        bool max_ok = false;
+        mapping.minimum = fields[1].trimmed().toInt(&min_ok);
+        mapping.maximum = fields[2].trimmed().toInt(&max_ok);
+        if (!min_ok || !max_ok || mapping.minimum >= mapping.maximum)
+            return std::nullopt;
+    }
+    return mapping;
+}
+
+template<std::size_t N>
+bool readGroup(QSettings &settings,
+               const QString &group,
+               std::array<GamepadProfile::Mapping, N> &mappings)
+{
+    settings.beginGroup(group);
+    const QStringList keys = settings.childKeys();
+    bool valid = true;
+    for (const QString &key : keys) {
+        bool ok = false;
+        const int code = key.toInt(&ok, 0);
+        const auto mapping = parseMapping(settings.value(key).toStringList());
+        if (!ok || code < 0 || code >= int(N) || !mapping) {
+            qWarning() << "Invalid gamepad mapping" << group << key;
+            valid = false;
+            continue;
+        }
+        mappings[code] = *mapping;
+    }
+    settings.endGroup();
+    return valid;
+}
+} // namespace
+
+GamepadProfile GamepadProfile::standard()
+{
+    GamepadProfile profile;
+    profile.name = u"standard"_s;
+    // evdev Y axes grow downwards
+    profile.axes[AbsX] = {Yaw};
+    profile.axes[AbsY] = {Throttle, true};
+    profile.axes[AbsRx] = {Roll};
+    profile.axes[AbsRy] = {Pitch, true};
+    profile.buttons[BtnSouth] = {StickChannelCount};
+    profile.buttons[BtnEast] = {StickChannelCount + 1};
+    profile.buttons[BtnNorth] = {StickChannelCount + 2};
+    profile.buttons[BtnWest] = {StickChannelCount + 3};
+    return profile;
+}
+
+std::optional<GamepadProfile> GamepadProfile::load(const QString &path)
+{
+    if (!QFileInfo(path).isReadable())
+        return std::nullopt;
+
+    QSettings settings(path, QSettings::IniFormat);
+    if (settings.status() != QSettings::NoError)
+        return std::nullopt;
+
+    GamepadProfile profile;
+    profile.name = QFileInfo(path).completeBaseName();
+    const bool axes = readGroup(settings, u"axes"_s, profile.axes);
+    const bool buttons = readGroup(settings, u"buttons"_s, profile.buttons);
+    if (!axes || !buttons)
+        return std::nullopt;
+
+    return profile;
+}
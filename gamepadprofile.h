@@ -0,0 +1,47 @@
+#ifndef GAMEPADPROFILE_H
+#define GAMEPADPROFILE_H
+
+#include <QString>
+
+#include <array>
+#include <optional>
+
+// Maps evdev axis and button codes to channels. Profiles are INI files,
+// keys are the codes from linux/input-event-codes.h:
+//
+//   [axes]
+//   0=yaw
+//   1=-throttle
+//   3=roll, -512, 511
+//   [buttons]
+//   304=aux1
+//
+// A leading minus inverts an axis, the optional range replaces the one the
+// device reports (recordings have none). Channels are roll, pitch,
+// throttle, yaw and aux1 onwards; a pressed button is full positive.
+struct GamepadProfile
+{
+    // ABS_CNT and KEY_CNT
+    static constexpr int axis_count = 0x40;
+    static constexpr int button_count = 0x300;
+
+    struct Mapping
+    {
+        // -1 when the code is not mapped
+        int channel = -1;
+        bool inverted = false;
+        // equal values use the range of the device
+        int minimum = 0;
+        int maximum = 0;
+    };
+
+    QString name;
+    std::array<Mapping, axis_count> axes;
+    std::array<Mapping, button_count> buttons;
+
+    // mode 2 on a gamepad with the standard Linux layout
+    static GamepadProfile standard();
+    static std::optional<GamepadProfile> load(const QString &path);
+};
+
+#endif // GAMEPADPROFILE_H
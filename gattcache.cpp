@@ -0,0 +1,56 @@
+#include "gattcache.h"
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// bump when the stored layout changes, older entries are ignored
+constexpr int cache_version = 2;
+
+QString group(const QString &address)
+{
+    // '/' is the QSettings group separator, ':' is not portable in keys
+    QString key = address;
+    return u"gatt/"_s + key.replace(':'_L1, '_'_L1).remove('{'_L1).remove('}'_L1);
+}
+} // namespace
+
+GattCache::GattCache()
+    : m_settings(QSettings::IniFormat, QSettings::UserScope, u"REMOTE_CONTROL_APP"_s, u"gattcache"_s)
+{}
+
+std::optional<GattCache::Layout> GattCache::find(const QString &address) const
+{
+    const QString prefix = group(address);
+    if (m_settings.value(prefix + "/version"_L1).toInt() != cache_version)
+        return std::nullopt;
+
+    Layout layout{QBluetoothUuid(m_settings.value(prefix + "/service"_L1).toString()),
+                  QBluetoothUuid(m_settings.value(prefix + "/tx"_L1).toString()),
+                  QBluetoothUuid(m_settings.value(prefix + "/rx"_L1).toString()),
+                  QLowEnergyCharacteristic::PropertyTypes::fromInt(
+                      m_settings.value(prefix + "/txProperties"_L1).toInt()),
+                  QLowEnergyCharacteristic::PropertyTypes::fromInt(
+                      m_settings.value(prefix + "/rxProperties"_L1).toInt()),
+                  m_settings.value(prefix + "/rxNotifiable"_L1).toBool()};
+    if (layout.service.isNull() || layout.tx.isNull() || layout.rx.isNull())
+        return std::nullopt;
+
+    return layout;
+}
+
+void GattCache::store(const QString &address, const Layout &layout)
+{
+    const QString prefix = group(address);
+    m_settings.setValue(prefix + "/version"_L1, cache_version);
+    m_settings.setValue(prefix + "/service"_L1, layout.service.toString());
+    m_settings.setValue(prefix + "/tx"_L1, layout.tx.toString());
+    m_settings.setValue(prefix + "/rx"_L1, layout.rx.toString());
+    m_settings.setValue(prefix + "/txProperties"_L1, layout.txProperties.toInt());
+    m_settings.setValue(prefix + "/rxProperties"_L1, layout.rxProperties.toInt());
+    m_settings.setValue(prefix + "/rxNotifiable"_L1, layout.rxNotifiable);
+}
+
+void GattCache::remove(const QString &address)
+{
+    m_settings.remove(group(address));
+}
@@ -0,0 +1,49 @@
+#ifndef GATTCACHE_H
+#define GATTCACHE_H
+
+#include <QBluetoothUuid>
+#include <QLowEnergyCharacteristic>
+#include <QSettings>
+#include <QString>
+
+#include <optional>
+
+// Remembers the RX/TX layout of vehicles we connected to before, keyed by
+// device address. A reconnect to a known vehicle starts on the service as
+// soon as it is discovered and skips reading characteristic values; the
+// discovered layout is then checked against the entry, see Device.
+//
+// QtBluetooth has no way to hand attribute handles back to the stack, the
+// layout is what can be checked after the shortened discovery.
+class GattCache
+{
+public:
+    struct Layout
+    {
+        QBluetoothUuid service;
+        QBluetoothUuid tx;
+        QBluetoothUuid rx;
+        QLowEnergyCharacteristic::PropertyTypes txProperties;
+        QLowEnergyCharacteristic::PropertyTypes rxProperties;
+        // RX has a client characteristic configuration to enable notifications
+        bool rxNotifiable = false;
+
+        bool operator==(const Layout &other) const
+        {
+            return service == other.service && tx == other.tx && rx == other.rx
+                   && txProperties == other.txProperties && rxProperties == other.rxProperties
+                   && rxNotifiable == other.rxNotifiable;
+        }
+    };
+
+    GattCache();
+
+    std::optional<Layout> find(const QString &address) const;
+    void store(const QString &address, const Layout &layout);
+    void remove(const QString &address);
+
+private:
+    QSettings m_settings;
+};
+
+#endif // GATTCACHE_H
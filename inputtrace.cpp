@@ -0,0 +1,250 @@
+#include "inputtrace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
+
+using namespace Qt::StringLiterals;
+
+namespace InputTrace {
+
+namespace {
+struct Record
+{
+    qint64 timestamp;
+    quint32 id;
+    quint8 stage;
+};
+
+// written by its owning thread only, drained under the registry mutex
+struct ThreadBuffer
+{
+    static constexpr quint32 capacity = 4096;
+
+    std::array<Record, capacity> records;
+    std::atomic<quint32> head{0};
+    std::atomic<quint32> tail{0};
+    std::atomic<quint64> lost{0};
+};
+
+struct Registry
+{
+    QMutex mutex;
+    QList<std::shared_ptr<ThreadBuffer>> buffers;
+    // first timestamp per stage of ids that are still in flight
+    QHash<quint32, std::array<qint64, StageCount>> pending;
+    std::array<LatencyHistogram, StageCount> latency;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+const char *const stage_names[StageCount] = {
+    "total",
+    "window -> stick slot",
+    "stick slot -> state",
+    "state -> frame encoded",
+    "frame -> writeData",
+    "writeData -> radio",
+};
+
+std::atomic<bool> enabled{false};
+std::atomic<qint64> last_input_event{0};
+thread_local quint32 current_id = 0;
+thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+
+QElapsedTimer &clock()
+{
+    static QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+ThreadBuffer &buffer()
+{
+    if (!thread_buffer) {
+        thread_buffer = std::make_shared<ThreadBuffer>();
+        QMutexLocker locker(&registry().mutex);
+        registry().buffers.append(thread_buffer);
+    }
+    return *thread_buffer;
+}
+
+class InputEventFilter : public QObject
+{
+public:
+    using QObject::QObject;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        switch (event->type()) {
+        case QEvent::TouchBegin:
+        case QEvent::TouchUpdate:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseMove:
+            // Qt Quick sends the same event on to items, stamp it once
+            if (watched->isWindowType() && enabled.load(std::memory_order_relaxed))
+                last_input_event.store(now(), std::memory_order_relaxed);
+            break;
+        default:
+            break;
+        }
+        return false;
+    }
+};
+} // namespace
+
+void install(QCoreApplication *app)
+{
+    app->installEventFilter(new InputEventFilter(app));
+}
+
+void setEnabled(bool on)
+{
+    enabled = on;
+}
+
+bool isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+qint64 now()
+{
+    return clock().nsecsElapsed();
+}
+
+qint64 lastInputEvent()
+{
+    return last_input_event.load(std::memory_order_relaxed);
+}
+
+void mark(Stage stage, quint32 id)
+{
+    if (!id || !enabled.load(std::memory_order_relaxed))
+        return;
+
+    mark(stage, id, now());
+}
+
+void mark(Stage stage, quint32 id, qint64 timestamp)
+{
+    if (!id || !enabled.load(std::memory_order_relaxed))
+        return;
+
+    ThreadBuffer &buf = buffer();
+    const quint32 head = buf.head.load(std::memory_order_relaxed);
+    if (head - buf.tail.load(std::memory_order_acquire) >= ThreadBuffer::capacity) {
+        buf.lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buf.records[head % ThreadBuffer::capacity] = {timestamp, id, quint8(stage)};
+    buf.head.store(head + 1, std::memory_order_release);
+}
+
+void setCurrent(quint32 id)
+{
+    current_id = id;
+}
+
+quint32 current()
+{
+    return current_id;
+}
+
+void collect()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    for (const auto &buf : std::as_const(reg.buffers)) {
+        const quint32 head = buf->head.load(std::memory_order_acquire);
+        for (quint32 tail = buf->tail.load(std::memory_order_relaxed); tail != head; ++tail) {
+            const Record &record = buf->records[tail % ThreadBuffer::capacity];
+            auto it = reg.pending.find(record.id);
+            if (it == reg.pending.end()) {
+                std::array<qint64, StageCount> stages;
+                stages.fill(-1);
+                it = reg.pending.insert(record.id, stages);
+            }
+            // heartbeat frames repeat an id, only its first occurrence counts
+            if (it->at(record.stage) < 0)
+                (*it)[record.stage] = record.timestamp;
+        }
+        buf->tail.store(head, std::memory_order_release);
+    }
+
+    // an id is complete once no frame has mentioned it for a while
+    const qint64 horizon = now() - 500 * 1000 * 1000;
+    for (auto it = reg.pending.begin(); it != reg.pending.end();) {
+        const std::array<qint64, StageCount> &stages = it.value();
+        qint64 newest = -1;
+        for (qint64 timestamp : stages)
+            newest = qMax(newest, timestamp);
+        if (newest > horizon) {
+            ++it;
+            continue;
+        }
+
+        qint64 previous = stages[TouchDispatched];
+        for (int stage = StickSlot; stage < StageCount; ++stage) {
+            if (stages[stage] < 0)
+                continue;
+            if (previous >= 0)
+                reg.latency[stage].record((stages[stage] - previous) / 1000);
+            previous = stages[stage];
+        }
+        if (stages[TouchDispatched] >= 0 && previous > stages[TouchDispatched])
+            reg.latency[TouchDispatched].record((previous - stages[TouchDispatched]) / 1000);
+
+        it = reg.pending.erase(it);
+    }
+}
+
+void reset()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.pending.clear();
+    for (LatencyHistogram &histogram : reg.latency)
+        histogram.reset();
+}
+
+const LatencyHistogram &stageLatency(Stage stage)
+{
+    return registry().latency[stage];
+}
+
+QString report()
+{
+    collect();
+
+    QString result = u"stage                          count     p50     p99     max (us)\n"_s;
+    // the hops in path order, then the total kept in the first slot
+    for (int i = StickSlot; i <= StageCount; ++i) {
+        const int stage = i == StageCount ? int(TouchDispatched) : i;
+        const LatencyHistogram &histogram = registry().latency[stage];
+        result += u"%1 %2 %3 %4 %5\n"_s.arg(QString::fromLatin1(stage_names[stage]), -28)
+                      .arg(histogram.count(), 7)
+                      .arg(histogram.percentile(50.0), 7)
+                      .arg(histogram.percentile(99.0), 7)
+                      .arg(histogram.max(), 7);
+    }
+    return result;
+}
+
+} // namespace InputTrace
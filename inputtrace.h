@@ -0,0 +1,61 @@
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#include <QString>
+
+#include <latencyhistogram.h>
+
+#include <array>
+
+QT_BEGIN_NAMESPACE
+class QCoreApplication;
+QT_END_NAMESPACE
+
+// Timestamps along the input-to-wire path. Every stage of a stick update is
+// marked with the ChannelState sequence the update produced, into a buffer
+// owned by the marking thread, so recording never takes a lock. collect()
+// pairs the marks up and accumulates how long each hop took.
+namespace InputTrace {
+
+enum Stage {
+    // the touch or mouse event reached the window
+    TouchDispatched,
+    // ControllerObject::leftStickMoved/rightStickMoved was entered
+    StickSlot,
+    // the value is in ChannelState
+    StateStored,
+    // the first frame carrying the value was encoded
+    FrameEncoded,
+    // Device::writeData handed the frame to the transport
+    WireDispatch,
+    // the transport handed the frame to the Bluetooth stack
+    RadioWrite,
+    StageCount
+};
+
+void install(QCoreApplication *app);
+void setEnabled(bool enabled);
+bool isEnabled();
+
+qint64 now();
+// nanoseconds timestamp of the input event currently being delivered
+qint64 lastInputEvent();
+
+// stamped with now(), the clock is only read while tracing is enabled
+void mark(Stage stage, quint32 id);
+void mark(Stage stage, quint32 id, qint64 timestamp);
+// the trace id of the frame being sent on this thread, 0 if none
+void setCurrent(quint32 id);
+quint32 current();
+
+// drains all thread buffers into the per stage statistics
+void collect();
+void reset();
+// latency from the previous stage to this one, the first stage holds the
+// total from TouchDispatched to the last stage that was reached
+const LatencyHistogram &stageLatency(Stage stage);
+QString report();
+
+} // namespace InputTrace
+
+#endif // INPUTTRACE_H
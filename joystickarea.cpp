@@ -0,0 +1,265 @@
+#include "joystickarea.h"
+
+#include <QEasingCurve>
+#include <QVariantAnimation>
+
+#include <cmath>
+
+JoyStickArea::JoyStickArea(QQuickItem *parent)
+    : QQuickItem{parent}
+{
+    setAcceptTouchEvents(true);
+    setAcceptedMouseButtons(Qt::LeftButton);
+
+    m_return_animation = new QVariantAnimation(this);
+    m_return_animation->setDuration(200);
+    m_return_animation->setEasingCurve(QEasingCurve::OutSine);
+    m_return_animation->setEndValue(QPointF());
+    connect(m_return_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
+        setThumb(value.toPointF());
+    });
+}
+
+ControllerObject *JoyStickArea::controller() const
+{
+    return m_controller;
+}
+
+void JoyStickArea::setController(ControllerObject *controller)
+{
+    if (m_controller == controller)
+        return;
+
+    m_controller = controller;
+    emit controllerChanged();
+}
+
+JoyStickArea::Stick JoyStickArea::stick() const
+{
+    return m_stick;
+}
+
+void JoyStickArea::setStick(Stick stick)
+{
+    if (m_stick == stick)
+        return;
+
+    m_stick = stick;
+    emit stickChanged();
+}
+
+bool JoyStickArea::verticalOnly() const
+{
+    return m_vertical_only;
+}
+
+void JoyStickArea::setVerticalOnly(bool value)
+{
+    if (m_vertical_only == value)
+        return;
+
+    m_vertical_only = value;
+    emit configChanged();
+    setThumb(m_thumb);
+}
+
+bool JoyStickArea::horizontalOnly() const
+{
+    return m_horizontal_only;
+}
+
+void JoyStickArea::setHorizontalOnly(bool value)
+{
+    if (m_horizontal_only == value)
+        return;
+
+    m_horizontal_only = value;
+    emit configChanged();
+    setThumb(m_thumb);
+}
+
+double JoyStickArea::horizontalTrim() const
+{
+    return m_horizontal_trim;
+}
+
+void JoyStickArea::setHorizontalTrim(double value)
+{
+    if (qFuzzyCompare(m_horizontal_trim, value))
+        return;
+
+    m_horizontal_trim = value;
+    emit configChanged();
+    updateOutput();
+}
+
+double JoyStickArea::verticalTrim() const
+{
+    return m_vertical_trim;
+}
+
+void JoyStickArea::setVerticalTrim(double value)
+{
+    if (qFuzzyCompare(m_vertical_trim, value))
+        return;
+
+    m_vertical_trim = value;
+    emit configChanged();
+    updateOutput();
+}
+
+double JoyStickArea::thumbSize() const
+{
+    return m_thumb_size;
+}
+
+void JoyStickArea::setThumbSize(double value)
+{
+    if (qFuzzyCompare(m_thumb_size, value))
+        return;
+
+    m_thumb_size = value;
+    emit configChanged();
+    setThumb(m_thumb);
+}
+
+double JoyStickArea::thumbX() const
+{
+    return m_thumb.x();
+}
+
+double JoyStickArea::thumbY() const
+{
+    return m_thumb.y();
+}
+
+double JoyStickArea::valueX() const
+{
+    return m_value_x;
+}
+
+double JoyStickArea::valueY() const
+{
+    return m_value_y;
+}
+
+void JoyStickArea::touchEvent(QTouchEvent *event)
+{
+    for (const QEventPoint &point : event->points()) {
+        if (m_touch_id < 0 && point.state() == QEventPoint::Pressed) {
+            m_touch_id = point.id();
+            press(point.position());
+        } else if (point.id() == m_touch_id) {
+            if (point.state() == QEventPoint::Released) {
+                m_touch_id = -1;
+                release();
+            } else {
+                moveTo(point.position());
+            }
+        }
+    }
+    event->accept();
+}
+
+void JoyStickArea::mousePressEvent(QMouseEvent *event)
+{
+    press(event->position());
+}
+
+void JoyStickArea::mouseMoveEvent(QMouseEvent *event)
+{
+    moveTo(event->position());
+}
+
+void JoyStickArea::mouseReleaseEvent(QMouseEvent *)
+{
+    release();
+}
+
+void JoyStickArea::mouseUngrabEvent()
+{
+    release();
+}
+
+void JoyStickArea::touchUngrabEvent()
+{
+    m_touch_id = -1;
+    release();
+}
+
+void JoyStickArea::press(const QPointF &position)
+{
+    m_return_animation->stop();
+    moveTo(position);
+}
+
+void JoyStickArea::moveTo(const QPointF &position)
+{
+    setThumb(position - QPointF(width() / 2, height() / 2));
+}
+
+void JoyStickArea::release()
+{
+    if (m_thumb.isNull())
+        return;
+
+    m_return_animation->stop();
+    m_return_animation->setStartValue(m_thumb);
+    m_return_animation->start();
+}
+
+void JoyStickArea::setThumb(const QPointF &offset)
+{
+    double x = m_vertical_only ? 0.0 : offset.x();
+    double y = m_horizontal_only ? 0.0 : offset.y();
+
+    const double bound = distanceBound();
+    const double distance = std::hypot(x, y);
+    if (distance > bound) {
+        const double scale = bound > 0.0 ? bound / distance : 0.0;
+        x *= scale;
+        y *= scale;
+    }
+
+    const QPointF thumb(x, y);
+    if (thumb != m_thumb) {
+        m_thumb = thumb;
+        emit thumbChanged();
+    }
+    updateOutput();
+}
+
+void JoyStickArea::updateOutput()
+{
+    const double bound = distanceBound();
+    const double x = bound > 0.0 ? m_thumb.x() / bound : 0.0;
+    const double y = bound > 0.0 ? -m_thumb.y() / bound : 0.0;
+    const double valueX = qBound(-1.0, x + m_horizontal_trim, 1.0);
+    const double valueY = qBound(-1.0, y + m_vertical_trim, 1.0);
+    if (valueX == m_value_x && valueY == m_value_y)
+        return;
+
+    m_value_x = valueX;
+    m_value_y = valueY;
+    emit valueChanged();
+    emit moved(m_value_x, m_value_y);
+
+    if (!m_controller)
+        return;
+
+    switch (m_stick) {
+    case LeftStick:
+        m_controller->leftStickMoved(m_value_x, m_value_y);
+        break;
+    case RightStick:
+        m_controller->rightStickMoved(m_value_x, m_value_y);
+        break;
+    case NoStick:
+        break;
+    }
+}
+
+double JoyStickArea::distanceBound() const
+{
+    return qMax(0.0, width() / 2 - m_thumb_size / 2);
+}
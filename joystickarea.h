@@ -0,0 +1,103 @@
+#ifndef JOYSTICKAREA_H
+#define JOYSTICKAREA_H
+
+#include <QPointF>
+#include <QQuickItem>
+
+#include <controllerobject.h>
+
+QT_BEGIN_NAMESPACE
+class QVariantAnimation;
+QT_END_NAMESPACE
+
+// Input side of JoyStick.qml. Turns touch and mouse input into the thumb
+// position and the normalised stick values, applies trims and hands the
+// result straight to the ControllerObject, so no JavaScript runs per event.
+class JoyStickArea : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(ControllerObject *controller READ controller WRITE setController
+                   NOTIFY controllerChanged)
+    Q_PROPERTY(Stick stick READ stick WRITE setStick NOTIFY stickChanged)
+    Q_PROPERTY(bool verticalOnly READ verticalOnly WRITE setVerticalOnly NOTIFY configChanged)
+    Q_PROPERTY(bool horizontalOnly READ horizontalOnly WRITE setHorizontalOnly
+                   NOTIFY configChanged)
+    Q_PROPERTY(double horizontalTrim READ horizontalTrim WRITE setHorizontalTrim
+                   NOTIFY configChanged)
+    Q_PROPERTY(double verticalTrim READ verticalTrim WRITE setVerticalTrim NOTIFY configChanged)
+    Q_PROPERTY(double thumbSize READ thumbSize WRITE setThumbSize NOTIFY configChanged)
+    Q_PROPERTY(double thumbX READ thumbX NOTIFY thumbChanged)
+    Q_PROPERTY(double thumbY READ thumbY NOTIFY thumbChanged)
+    Q_PROPERTY(double valueX READ valueX NOTIFY valueChanged)
+    Q_PROPERTY(double valueY READ valueY NOTIFY valueChanged)
+
+    QML_ELEMENT
+
+public:
+    enum Stick { NoStick, LeftStick, RightStick };
+    Q_ENUM(Stick)
+
+    explicit JoyStickArea(QQuickItem *parent = nullptr);
+
+    ControllerObject *controller() const;
+    void setController(ControllerObject *controller);
+    Stick stick() const;
+    void setStick(Stick stick);
+
+    bool verticalOnly() const;
+    void setVerticalOnly(bool value);
+    bool horizontalOnly() const;
+    void setHorizontalOnly(bool value);
+    double horizontalTrim() const;
+    void setHorizontalTrim(double value);
+    double verticalTrim() const;
+    void setVerticalTrim(double value);
+    double thumbSize() const;
+    void setThumbSize(double value);
+
+    // thumb offset from the centre in pixels
+    double thumbX() const;
+    double thumbY() const;
+    // trimmed output in [-1, 1], y points up
+    double valueX() const;
+    double valueY() const;
+
+signals:
+    void controllerChanged();
+    void stickChanged();
+    void configChanged();
+    void thumbChanged();
+    void valueChanged();
+    void moved(double x, double y);
+
+protected:
+    void touchEvent(QTouchEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseUngrabEvent() override;
+    void touchUngrabEvent() override;
+
+private:
+    void press(const QPointF &position);
+    void moveTo(const QPointF &position);
+    void release();
+    void setThumb(const QPointF &offset);
+    void updateOutput();
+    double distanceBound() const;
+
+    ControllerObject *m_controller = nullptr;
+    Stick m_stick = NoStick;
+    QVariantAnimation *m_return_animation = nullptr;
+    QPointF m_thumb;
+    double m_value_x = 0.0;
+    double m_value_y = 0.0;
+    double m_horizontal_trim = 0.0;
+    double m_vertical_trim = 0.0;
+    double m_thumb_size = 0.0;
+    int m_touch_id = -1;
+    bool m_vertical_only = false;
+    bool m_horizontal_only = false;
+};
+
+#endif // JOYSTICKAREA_H
@@ -0,0 +1,131 @@
+#include "latencyhistogram.h"
+
+#include <QtAlgorithms>
+
+#include <limits>
+
+namespace {
+constexpr qint64 max_trackable = (qint64(1) << 31) - 1;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 usec)
+{
+    usec = qBound<qint64>(0, usec, max_trackable);
+    m_buckets[bucketIndex(usec)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(quint64(usec), std::memory_order_relaxed);
+
+    qint64 current = m_min.load(std::memory_order_relaxed);
+    while (usec < current
+           && !m_min.compare_exchange_weak(current, usec, std::memory_order_relaxed)) {
+    }
+    current = m_max.load(std::memory_order_relaxed);
+    while (usec > current
+           && !m_max.compare_exchange_weak(current, usec, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<qint64>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < bucket_count; ++i) {
+        m_buckets[i].fetch_add(other.m_buckets[i].load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+    }
+    m_count.fetch_add(other.count(), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (other.count()) {
+        m_min.store(qMin(m_min.load(std::memory_order_relaxed), other.min()),
+                    std::memory_order_relaxed);
+        m_max.store(qMax(m_max.load(std::memory_order_relaxed), other.max()),
+                    std::memory_order_relaxed);
+    }
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+qint64 LatencyHistogram::min() const
+{
+    return count() ? m_min.load(std::memory_order_relaxed) : 0;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    const quint64 total = count();
+    return total ? double(m_sum.load(std::memory_order_relaxed)) / total : 0.0;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const
+{
+    const quint64 total = count();
+    if (!total)
+        return 0;
+
+    const quint64 rank = qMax<quint64>(1, quint64(qBound(0.0, percent, 100.0) / 100.0 * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < bucket_count; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return qMin(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+int LatencyHistogram::bucketIndex(qint64 usec)
+{
+    // the first 2 * sub_bucket_count values get exact buckets, above that
+    // every power of two is split into sub_bucket_count linear steps
+    if (usec < 2 * sub_bucket_count)
+        return int(usec);
+
+    const int msb = 63 - int(qCountLeadingZeroBits(quint64(usec)));
+    const int shift = msb - sub_bucket_bits;
+    return 2 * sub_bucket_count + (shift - 1) * sub_bucket_count
+           + int(usec >> shift) - sub_bucket_count;
+}
+
+qint64 LatencyHistogram::bucketLowerBound(int index)
+{
+    if (index < 2 * sub_bucket_count)
+        return index;
+
+    const int shift = (index - 2 * sub_bucket_count) / sub_bucket_count + 1;
+    const int sub = (index - 2 * sub_bucket_count) % sub_bucket_count + sub_bucket_count;
+    return qint64(sub) << shift;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < 2 * sub_bucket_count)
+        return index;
+
+    const int shift = (index - 2 * sub_bucket_count) / sub_bucket_count + 1;
+    return bucketLowerBound(index) + (qint64(1) << shift) - 1;
+}
+
+quint64 LatencyHistogram::bucketCount(int index) const
+{
+    return m_buckets[index].load(std::memory_order_relaxed);
+}
@@ -0,0 +1,46 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+
+// Log-linear (HDR style) histogram of microsecond values, ~3% relative error
+// up to ~35 minutes. record() is wait-free, so one thread can record while
+// another reads percentiles.
+class LatencyHistogram
+{
+public:
+    static constexpr int sub_bucket_bits = 5;
+    static constexpr int sub_bucket_count = 1 << sub_bucket_bits;
+    static constexpr int bucket_count = 2 * sub_bucket_count
+                                        + (31 - sub_bucket_bits) * sub_bucket_count;
+
+    LatencyHistogram();
+
+    void record(qint64 usec);
+    void reset();
+    void merge(const LatencyHistogram &other);
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    // percentile in [0, 100], returns the upper bound of the matching bucket
+    qint64 percentile(double percent) const;
+
+    static int bucketIndex(qint64 usec);
+    static qint64 bucketLowerBound(int index);
+    static qint64 bucketUpperBound(int index);
+    quint64 bucketCount(int index) const;
+
+private:
+    std::array<std::atomic<quint64>, bucket_count> m_buckets;
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+    std::atomic<qint64> m_min{0};
+    std::atomic<qint64> m_max{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,177 @@
+#include "latencyprobe.h"
+
+#include <controlprotocol.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+LatencyProbe::LatencyProbe(QObject *parent)
+    : QObject{parent}
+{
+    m_clock.start();
+    m_frame.resize(ControlProtocol::encodedSize(0));
+
+    m_probe_timer = new QTimer(this);
+    m_probe_timer->setInterval(100);
+    connect(m_probe_timer, &QTimer::timeout, this, &LatencyProbe::sendProbe);
+
+    m_statistics_timer = new QTimer(this);
+    m_statistics_timer->setInterval(500);
+    connect(m_statistics_timer, &QTimer::timeout, this, &LatencyProbe::statisticsChanged);
+}
+
+bool LatencyProbe::isEnabled() const
+{
+    return m_probe_timer->isActive();
+}
+
+void LatencyProbe::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled())
+        return;
+
+    if (enabled && !m_available) {
+        qWarning() << "Latency probes need a ControlProtocol frame format";
+        return;
+    }
+
+    if (enabled) {
+        m_probe_timer->start();
+        m_statistics_timer->start();
+    } else {
+        m_probe_timer->stop();
+        m_statistics_timer->stop();
+    }
+    emit enabledChanged();
+}
+
+bool LatencyProbe::isAvailable() const
+{
+    return m_available;
+}
+
+void LatencyProbe::setAvailable(bool available)
+{
+    if (m_available == available)
+        return;
+
+    m_available = available;
+    if (!m_available)
+        setEnabled(false);
+    emit availableChanged();
+}
+
+int LatencyProbe::interval() const
+{
+    return m_probe_timer->interval();
+}
+
+void LatencyProbe::setInterval(int msec)
+{
+    msec = qMax(msec, 1);
+    if (msec == interval())
+        return;
+
+    m_probe_timer->setInterval(msec);
+    emit intervalChanged();
+}
+
+double LatencyProbe::p50() const
+{
+    return m_histogram.percentile(50.0) / 1000.0;
+}
+
+double LatencyProbe::p99() const
+{
+    return m_histogram.percentile(99.0) / 1000.0;
+}
+
+double LatencyProbe::p999() const
+{
+    return m_histogram.percentile(99.9) / 1000.0;
+}
+
+double LatencyProbe::max() const
+{
+    return m_histogram.max() / 1000.0;
+}
+
+quint64 LatencyProbe::received() const
+{
+    return m_histogram.count();
+}
+
+quint64 LatencyProbe::lost() const
+{
+    return m_lost;
+}
+
+const LatencyHistogram &LatencyProbe::histogram() const
+{
+    return m_histogram;
+}
+
+void LatencyProbe::reset()
+{
+    for (auto &slot : m_outstanding)
+        slot.store(0, std::memory_order_relaxed);
+    m_histogram.reset();
+    m_lost = 0;
+    emit statisticsChanged();
+}
+
+bool LatencyProbe::exportCsv(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "lower_us,upper_us,count,cumulative_percent\n";
+    const quint64 total = m_histogram.count();
+    quint64 seen = 0;
+    for (int i = 0; i < LatencyHistogram::bucket_count; ++i) {
+        const quint64 count = m_histogram.bucketCount(i);
+        if (!count)
+            continue;
+
+        seen += count;
+        out << LatencyHistogram::bucketLowerBound(i) << ',' << LatencyHistogram::bucketUpperBound(i)
+            << ',' << count << ',' << (100.0 * seen / total) << '\n';
+    }
+    return out.status() == QTextStream::Ok;
+}
+
+void LatencyProbe::pongReceived(quint16 sequence, quint32 timestamp)
+{
+    std::atomic<quint32> &slot = m_outstanding[sequence % outstanding_size];
+    quint32 sent = timestamp;
+    // only the first answer to a probe we actually sent counts
+    if (!timestamp || !slot.compare_exchange_strong(sent, 0))
+        return;
+
+    m_histogram.record(qint64(quint32(now() - timestamp)));
+}
+
+void LatencyProbe::sendProbe()
+{
+    const quint32 timestamp = qMax<quint32>(now(), 1);
+
+    std::atomic<quint32> &slot = m_outstanding[m_sequence % outstanding_size];
+    if (slot.exchange(timestamp))
+        ++m_lost;
+
+    ControlProtocol::ChannelFrame probe;
+    probe.type = ControlProtocol::FrameType::Ping;
+    probe.sequence = m_sequence++;
+    probe.timestamp = timestamp;
+    ControlProtocol::encode(probe, m_frame.data());
+    emit probeReady(m_frame);
+}
+
+quint32 LatencyProbe::now() const
+{
+    return quint32(m_clock.nsecsElapsed() / 1000);
+}
@@ -0,0 +1,90 @@
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <latencyhistogram.h>
+
+#include <array>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// Round trip latency over the control link. Sends timestamped Ping frames
+// through the same path as control frames and matches the Pong (or, with a
+// loopback peripheral, the echoed Ping) coming back on the RX characteristic.
+// Only available while the link speaks ControlProtocol, a receiver of raw
+// frames would take a Ping for stick values.
+class LatencyProbe : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(bool available READ isAvailable NOTIFY availableChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(double p50 READ p50 NOTIFY statisticsChanged)
+    Q_PROPERTY(double p99 READ p99 NOTIFY statisticsChanged)
+    Q_PROPERTY(double p999 READ p999 NOTIFY statisticsChanged)
+    Q_PROPERTY(double max READ max NOTIFY statisticsChanged)
+    Q_PROPERTY(quint64 received READ received NOTIFY statisticsChanged)
+    Q_PROPERTY(quint64 lost READ lost NOTIFY statisticsChanged)
+
+public:
+    explicit LatencyProbe(QObject *parent = nullptr);
+
+    bool isEnabled() const;
+    // refused while not available
+    void setEnabled(bool enabled);
+    bool isAvailable() const;
+    // stops probing when the link no longer understands Ping frames
+    void setAvailable(bool available);
+    int interval() const;
+    void setInterval(int msec);
+
+    // milliseconds
+    double p50() const;
+    double p99() const;
+    double p999() const;
+    double max() const;
+    quint64 received() const;
+    // probes still unanswered when their sequence slot came around again
+    quint64 lost() const;
+
+    const LatencyHistogram &histogram() const;
+
+    Q_INVOKABLE void reset();
+    // one row per non-empty histogram bucket, false if path can't be written
+    Q_INVOKABLE bool exportCsv(const QString &path) const;
+
+public slots:
+    // safe to call from any thread
+    void pongReceived(quint16 sequence, quint32 timestamp);
+
+signals:
+    void enabledChanged();
+    void availableChanged();
+    void intervalChanged();
+    void statisticsChanged();
+    void probeReady(const QByteArray &frame);
+
+private:
+    void sendProbe();
+    quint32 now() const;
+
+    static constexpr int outstanding_size = 64;
+
+    QTimer *m_probe_timer = nullptr;
+    QTimer *m_statistics_timer = nullptr;
+    QElapsedTimer m_clock;
+    QByteArray m_frame;
+    quint16 m_sequence = 0;
+    bool m_available = false;
+    // send time per sequence slot, 0 once answered
+    std::array<std::atomic<quint32>, outstanding_size> m_outstanding{};
+    LatencyHistogram m_histogram;
+    std::atomic<quint64> m_lost{0};
+};
+
+#endif // LATENCYPROBE_H
@@ -0,0 +1,174 @@
+#include "linkscheduler.h"
+
+#include <QTimer>
+
+#include <eventtrace.h>
+#include <loopbacklinktransport.h>
+
+namespace {
+constexpr int statistics_interval_ms = 500;
+} // namespace
+
+LinkScheduler::LinkScheduler(QObject *parent)
+    : QObject{parent}
+{
+    m_time.start();
+    m_active.reserve(max_links);
+
+    m_clock = new FrameScheduler(this);
+    // runs on the frame clock thread
+    connect(m_clock, &FrameScheduler::frameDue, this, &LinkScheduler::tick, Qt::DirectConnection);
+
+    m_statistics_timer = new QTimer(this);
+    m_statistics_timer->setInterval(statistics_interval_ms);
+    connect(m_statistics_timer, &QTimer::timeout, this, &LinkScheduler::updateStatistics);
+}
+
+LinkScheduler::~LinkScheduler()
+{
+    m_clock->stop();
+}
+
+FrameScheduler *LinkScheduler::clock() const
+{
+    return m_clock;
+}
+
+QList<VehicleLink *> LinkScheduler::links() const
+{
+    return m_links;
+}
+
+int LinkScheduler::count() const
+{
+    return int(m_links.size());
+}
+
+int LinkScheduler::framesPerTick() const
+{
+    return m_frames_per_tick;
+}
+
+void LinkScheduler::setFramesPerTick(int frames)
+{
+    frames = qMax(frames, 0);
+    if (m_frames_per_tick.exchange(frames) == frames)
+        return;
+
+    emit framesPerTickChanged();
+}
+
+bool LinkScheduler::addLink(VehicleLink *link)
+{
+    if (!link || m_links.contains(link))
+        return false;
+
+    if (m_links.size() >= max_links) {
+        delete link;
+        return false;
+    }
+
+    link->setParent(this);
+    m_links.append(link);
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_active = m_links;
+    }
+    connect(link, &VehicleLink::linkIntervalChanged, this, &LinkScheduler::updateClockInterval);
+    updateClockInterval();
+
+    if (!m_clock->isActive()) {
+        m_clock->start();
+        m_statistics_clock.start();
+        m_statistics_timer->start();
+    }
+    emit linksChanged();
+    return true;
+}
+
+void LinkScheduler::removeLink(VehicleLink *link)
+{
+    if (!link || link->isPrimary() || !m_links.removeOne(link))
+        return;
+
+    {
+        // the clock thread is not inside tick() once we hold the lock
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_active = m_links;
+        m_next = 0;
+    }
+    link->deleteLater();
+    updateClockInterval();
+
+    if (m_links.isEmpty()) {
+        m_clock->stop();
+        m_statistics_timer->stop();
+    }
+    emit linksChanged();
+}
+
+VehicleLink *LinkScheduler::addLoopbackLink(const QString &name)
+{
+    auto transport = new LoopbackLinkTransport;
+    transport->open();
+    auto link = new VehicleLink(name, transport, m_clock);
+    return addLink(link) ? link : nullptr;
+}
+
+void LinkScheduler::removeAllLinks()
+{
+    const QList<VehicleLink *> links = m_links;
+    for (VehicleLink *link : links)
+        removeLink(link);
+}
+
+void LinkScheduler::tick()
+{
+    EVENT_TRACE_SCOPE("frame", "linkTick");
+    std::lock_guard<std::mutex> locker(m_mutex);
+    const int count = int(m_active.size());
+    if (count == 0)
+        return;
+
+    const int budget = m_frames_per_tick > 0 ? qMin(int(m_frames_per_tick), count) : count;
+    const qint64 now = m_time.nsecsElapsed() / 1000;
+    // any controller wakes the clock, the others have nothing new to send
+    const bool on_change = m_clock->mode() == FrameScheduler::OnChange;
+    const qint64 heartbeat = qint64(m_clock->heartbeatInterval()) * 1000;
+    int served = 0;
+    bool pending = false;
+    for (int i = 0; i < count; ++i) {
+        const int index = (m_next + i) % count;
+        VehicleLink *link = m_active.at(index);
+        if (!link->isReady()) {
+            link->markIdle();
+            continue;
+        }
+
+        if (served == budget || (on_change && !link->isFrameDue(now, heartbeat))) {
+            pending = pending || link->hasPendingChange();
+            continue;
+        }
+
+        link->sendFrame(now);
+        ++served;
+        m_next = (index + 1) % count;
+    }
+
+    // otherwise the changes left over would wait for the next heartbeat
+    if (on_change && pending)
+        m_clock->markChanged();
+}
+
+void LinkScheduler::updateClockInterval()
+{
+    // fixed rate frames can only line up with the connection events of one link
+    m_clock->setLinkInterval(m_links.size() == 1 ? m_links.first()->linkInterval() : 0);
+}
+
+void LinkScheduler::updateStatistics()
+{
+    const qint64 elapsed = m_statistics_clock.restart();
+    for (VehicleLink *link : std::as_const(m_links))
+        link->updateStatistics(elapsed);
+}
@@ -0,0 +1,76 @@
+#ifndef LINKSCHEDULER_H
+#define LINKSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+
+#include <framescheduler.h>
+#include <vehiclelink.h>
+
+#include <mutex>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// Drives the frames of several vehicles from one frame clock. Every tick
+// serves the ready links round robin, starting after the last link served,
+// so with a per tick budget (framesPerTick) every link still gets its turn.
+// In OnChange mode a link only gets a frame when its own input changed or
+// its heartbeat is due, see VehicleLink::isFrameDue(). The clock follows
+// the link interval of a single link, with more vehicles each keeps its own.
+// Device's primary vehicle is one of the links.
+class LinkScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(FrameScheduler *clock READ clock CONSTANT)
+    Q_PROPERTY(QList<VehicleLink *> links READ links NOTIFY linksChanged)
+    Q_PROPERTY(int count READ count NOTIFY linksChanged)
+    // 0 serves every ready link on every tick
+    Q_PROPERTY(int framesPerTick READ framesPerTick WRITE setFramesPerTick
+                   NOTIFY framesPerTickChanged)
+
+public:
+    static constexpr int max_links = 16;
+
+    explicit LinkScheduler(QObject *parent = nullptr);
+    ~LinkScheduler();
+
+    FrameScheduler *clock() const;
+    QList<VehicleLink *> links() const;
+    int count() const;
+    int framesPerTick() const;
+    void setFramesPerTick(int frames);
+
+    // takes ownership, returns false when max_links are already connected
+    bool addLink(VehicleLink *link);
+    // the primary vehicle stays until the scheduler goes
+    Q_INVOKABLE void removeLink(VehicleLink *link);
+    // in-process stand-in peripheral, for demos and testing without vehicles
+    Q_INVOKABLE VehicleLink *addLoopbackLink(const QString &name);
+    Q_INVOKABLE void removeAllLinks();
+
+signals:
+    void linksChanged();
+    void framesPerTickChanged();
+
+private:
+    // clock thread
+    void tick();
+    void updateStatistics();
+    void updateClockInterval();
+
+    FrameScheduler *m_clock = nullptr;
+    QTimer *m_statistics_timer = nullptr;
+    QElapsedTimer m_statistics_clock;
+    QElapsedTimer m_time;
+    QList<VehicleLink *> m_links;
+    // what the clock thread iterates, guarded by m_mutex
+    std::mutex m_mutex;
+    QList<VehicleLink *> m_active;
+    int m_next = 0;
+    std::atomic<int> m_frames_per_tick{0};
+};
+
+#endif // LINKSCHEDULER_H
@@ -0,0 +1,54 @@
+#ifndef LINKTRANSPORT_H
+#define LINKTRANSPORT_H
+
+#include <QByteArray>
+#include <QObject>
+
+#include <latencyhistogram.h>
+#include <writequeue.h>
+
+// Link between the controller and one vehicle. Device only talks to this
+// interface, so the radio can be swapped for an in-process stand-in.
+class LinkTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkTransport(QObject *parent = nullptr)
+        : QObject{parent}
+    {}
+
+    virtual bool isReady() const = 0;
+    // negotiated ATT MTU, a single write may carry mtu() - 3 bytes
+    virtual int mtu() const = 0;
+    // called from the frame clock thread, implementations must be thread safe.
+    // Writes are queued until the radio has room, see WriteQueue.
+    virtual bool write(const QByteArray &data, WriteQueue::Kind kind = WriteQueue::ControlFrame) = 0;
+
+    Q_INVOKABLE int queueDepth() const { return m_write_queue.depth(); }
+    Q_INVOKABLE int maxQueueDepth() const { return m_write_queue.maxDepth(); }
+    // control frames replaced by a newer one before they were sent
+    Q_INVOKABLE quint64 staleFramesDropped() const { return m_write_queue.staleFramesDropped(); }
+    Q_INVOKABLE quint64 messagesDropped() const { return m_write_queue.messagesDropped(); }
+
+    // from write() until the radio took the packet, in microseconds
+    const LatencyHistogram &radioLatency() const { return m_radio_latency; }
+    void resetRadioLatency() { m_radio_latency.reset(); }
+
+signals:
+    void readyChanged();
+    void mtuChanged();
+    // notification received on the RX characteristic
+    void dataReceived(const QByteArray &data);
+
+protected:
+    // call as a queued entry is handed to the radio
+    void markRadioWrite(const WriteQueue::Entry &entry)
+    {
+        m_radio_latency.record((WriteQueue::now() - entry.queuedNs) / 1000);
+    }
+
+    WriteQueue m_write_queue;
+    LatencyHistogram m_radio_latency;
+};
+
+#endif // LINKTRANSPORT_H
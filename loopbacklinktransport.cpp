@@ -0,0 +1,128 @@
+#include "loopbacklinktransport.h"
+
+#include <QTimer>
+
+#include <eventtrace.h>
+#include <inputtrace.h>
+
+namespace {
+// ATT header of a write command
+constexpr int att_write_overhead = 3;
+constexpr int max_packets_per_event = 32;
+} // namespace
+
+LoopbackLinkTransport::LoopbackLinkTransport(QObject *parent)
+    : LinkTransport{parent}
+{
+    m_in_flight.reserve(max_packets_per_event);
+
+    m_event_timer = new QTimer(this);
+    m_event_timer->setTimerType(Qt::PreciseTimer);
+    m_event_timer->setInterval(15);
+    connect(m_event_timer, &QTimer::timeout, this, &LoopbackLinkTransport::connectionEvent);
+}
+
+bool LoopbackLinkTransport::isReady() const
+{
+    return m_open;
+}
+
+int LoopbackLinkTransport::mtu() const
+{
+    return m_mtu;
+}
+
+bool LoopbackLinkTransport::write(const QByteArray &data, WriteQueue::Kind kind)
+{
+    if (!m_open || data.size() > m_mtu - att_write_overhead) {
+        ++m_rejected;
+        return false;
+    }
+
+    ++m_written;
+    m_write_queue.push(data, kind, InputTrace::current());
+    return true;
+}
+
+void LoopbackLinkTransport::open()
+{
+    if (m_open)
+        return;
+
+    m_open = true;
+    m_event_timer->start();
+    emit readyChanged();
+}
+
+void LoopbackLinkTransport::close()
+{
+    if (!m_open)
+        return;
+
+    m_open = false;
+    m_event_timer->stop();
+    m_write_queue.clear();
+    emit readyChanged();
+}
+
+void LoopbackLinkTransport::setMtu(int mtu)
+{
+    mtu = qMax(mtu, 23);
+    if (m_mtu.exchange(mtu) != mtu)
+        emit mtuChanged();
+}
+
+void LoopbackLinkTransport::setConnectionInterval(int msec)
+{
+    m_event_timer->setInterval(qMax(msec, 1));
+}
+
+int LoopbackLinkTransport::connectionInterval() const
+{
+    return m_event_timer->interval();
+}
+
+void LoopbackLinkTransport::setDropRate(double rate)
+{
+    m_drop_rate = qBound(0.0, rate, 1.0);
+}
+
+void LoopbackLinkTransport::setPacketsPerEvent(int count)
+{
+    m_packets_per_event = qBound(1, count, max_packets_per_event);
+}
+
+void LoopbackLinkTransport::setEcho(bool echo)
+{
+    m_echo = echo;
+}
+
+void LoopbackLinkTransport::setSeed(quint32 seed)
+{
+    m_random.seed(seed);
+}
+
+void LoopbackLinkTransport::connectionEvent()
+{
+    EVENT_TRACE_SCOPE("frame", "radioWrite");
+    EVENT_TRACE_COUNTER("frame", "writeQueueDepth", m_write_queue.depth());
+    m_write_queue.take(m_packets_per_event, m_in_flight);
+
+    for (const WriteQueue::Entry &entry : std::as_const(m_in_flight)) {
+        const QByteArray &packet = entry.data;
+        InputTrace::mark(InputTrace::RadioWrite, entry.traceId);
+        markRadioWrite(entry);
+        if (m_drop_rate > 0.0 && m_random.generateDouble() < m_drop_rate) {
+            ++m_dropped;
+            continue;
+        }
+
+        ++m_delivered;
+        emit peripheralReceived(packet);
+        if (m_echo) {
+            EVENT_TRACE_SCOPE("rx", "notification");
+            emit dataReceived(packet);
+        }
+    }
+    m_in_flight.clear();
+}
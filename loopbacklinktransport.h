@@ -0,0 +1,70 @@
+#ifndef LOOPBACKLINKTRANSPORT_H
+#define LOOPBACKLINKTRANSPORT_H
+
+#include "linktransport.h"
+
+#include <QList>
+#include <QRandomGenerator>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// In-process stand-in for a Nordic UART (6e400001) peripheral. Writes to the
+// TX characteristic go through the same latest-wins WriteQueue as the radio,
+// are handed over once per connection event, optionally dropped, and echoed
+// back as RX notifications.
+class LoopbackLinkTransport : public LinkTransport
+{
+    Q_OBJECT
+public:
+    explicit LoopbackLinkTransport(QObject *parent = nullptr);
+
+    bool isReady() const override;
+    int mtu() const override;
+    bool write(const QByteArray &data, WriteQueue::Kind kind = WriteQueue::ControlFrame) override;
+
+    void open();
+    void close();
+
+    void setMtu(int mtu);
+    void setConnectionInterval(int msec);
+    int connectionInterval() const;
+    // probability in [0, 1] that a packet is lost over the air
+    void setDropRate(double rate);
+    void setPacketsPerEvent(int count);
+    void setEcho(bool echo);
+    void setSeed(quint32 seed);
+
+    quint64 writtenPackets() const { return m_written; }
+    quint64 deliveredPackets() const { return m_delivered; }
+    quint64 droppedPackets() const { return m_dropped; }
+    quint64 rejectedPackets() const { return m_rejected; }
+
+    // hands queued packets to the peripheral, driven by the event timer while
+    // open. Tests step it by hand to stay off the event loop.
+    void connectionEvent();
+
+signals:
+    // payload as seen by the peripheral's RX characteristic
+    void peripheralReceived(const QByteArray &data);
+
+private:
+    QTimer *m_event_timer = nullptr;
+    // reused by every connection event to stay allocation free
+    QList<WriteQueue::Entry> m_in_flight;
+    QRandomGenerator m_random;
+    std::atomic<int> m_mtu{23};
+    int m_packets_per_event = 4;
+    double m_drop_rate = 0.0;
+    bool m_echo = true;
+    std::atomic<bool> m_open{false};
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_delivered{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_rejected{0};
+};
+
+#endif // LOOPBACKLINKTRANSPORT_H
@@ -1,9 +1,14 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 
+#include <eventtrace.h>
+#include <inputtrace.h>
+
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
+    InputTrace::install(&app);
+    EventTrace::install(&app);
 
     QQmlApplicationEngine engine;
     QObject::connect(
@@ -0,0 +1,22 @@
+#include "responsecurve.h"
+
+namespace ResponseCurve {
+
+namespace {
+constexpr std::array<Table, PresetCount> presets = {
+    makeTable(0.0, 1.0, 0.0),
+    makeTable(0.3, 1.0, 0.0),
+    makeTable(0.5, 1.0, 0.0),
+    makeTable(0.7, 1.0, 0.0),
+    makeTable(0.4, 0.6, 0.02),
+};
+static_assert(presets[Linear][segments] == full_scale);
+static_assert(presets[Linear][segments / 5] == full_scale / 5);
+} // namespace
+
+const Table &preset(Preset preset)
+{
+    return presets[preset < PresetCount ? preset : Linear];
+}
+
+} // namespace ResponseCurve
@@ -0,0 +1,56 @@
+#ifndef RESPONSECURVE_H
+#define RESPONSECURVE_H
+
+#include <QtGlobal>
+
+#include <array>
+
+// Stick response curves as lookup tables over the positive half of the
+// channel range, evaluated with linear interpolation. Curves are odd
+// symmetric: deadband first, then expo, then rate.
+namespace ResponseCurve {
+
+// channel value of a fully deflected stick
+constexpr int full_scale = 10000;
+constexpr int segments = 125;
+constexpr int segment_width = full_scale / segments;
+static_assert(segments * segment_width == full_scale);
+
+using Table = std::array<qint16, segments + 1>;
+
+enum Preset { Linear, Expo30, Expo50, Expo70, LowRate, PresetCount };
+
+// expo in [0, 1] blends linear with cubic, rate scales the output
+// (dual rate), deadband is the fraction of travel that reads as centre
+constexpr Table makeTable(double expo, double rate, double deadband)
+{
+    Table table{};
+    for (int i = 0; i <= segments; ++i) {
+        double x = double(i) / segments;
+        x = x <= deadband ? 0.0 : (x - deadband) / (1.0 - deadband);
+        double y = ((1.0 - expo) * x + expo * x * x * x) * rate;
+        y = y > 1.0 ? 1.0 : y;
+        table[i] = qint16(y * full_scale + 0.5);
+    }
+    return table;
+}
+
+const Table &preset(Preset preset);
+
+inline qint16 apply(const Table &table, qint16 value)
+{
+    const bool negative = value < 0;
+    int magnitude = negative ? -int(value) : int(value);
+    if (magnitude >= full_scale) {
+        magnitude = table[segments];
+    } else {
+        const int index = magnitude / segment_width;
+        const int fraction = magnitude % segment_width;
+        magnitude = table[index] + (table[index + 1] - table[index]) * fraction / segment_width;
+    }
+    return qint16(negative ? -magnitude : magnitude);
+}
+
+} // namespace ResponseCurve
+
+#endif // RESPONSECURVE_H
@@ -12,13 +12,20 @@ using namespace Qt::StringLiterals;
 ServiceInfo::ServiceInfo(QLowEnergyService *service):
     m_service(service)
 {
-    m_service->setParent(this);
     if (m_service) {
         m_is_rx_tx = (m_service->serviceUuid().toString()
                       == "{6e400001-b5a3-f393-e0a9-e50e24dcca9e}");
     }
 }
 
+ServiceInfo::~ServiceInfo()
+{
+    // the service lives on the controller's thread, a reconnect to the same
+    // controller would pile them up otherwise
+    if (m_service)
+        m_service->deleteLater();
+}
+
 QLowEnergyService *ServiceInfo::service() const
 {
     return m_service;
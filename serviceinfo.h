@@ -6,6 +6,7 @@
 #define SERVICEINFO_H
 
 #include <QObject>
+#include <QPointer>
 
 #include <QQmlEngine>
 
@@ -25,7 +26,9 @@ class ServiceInfo: public QObject
 
 public:
     ServiceInfo() = default;
+    // the service stays a child of its controller, see the destructor
     ServiceInfo(QLowEnergyService *service);
+    ~ServiceInfo();
     QLowEnergyService *service() const;
     QString getUuid() const;
     QString getName() const;
@@ -36,7 +39,7 @@ Q_SIGNALS:
     void serviceChanged();
 
 private:
-    QLowEnergyService *m_service = nullptr;
+    QPointer<QLowEnergyService> m_service;
     bool m_is_rx_tx = false;
 };
 
@@ -0,0 +1,80 @@
+#include "servicelistmodel.h"
+
+ServiceListModel::ServiceListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{}
+
+ServiceListModel::~ServiceListModel()
+{
+    for (const Entry &entry : std::as_const(m_entries))
+        delete entry.service;
+}
+
+int ServiceListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_entries.size());
+}
+
+QVariant ServiceListModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid))
+        return QVariant();
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return entry.name;
+    case UuidRole:
+        return entry.uuid;
+    case TypeRole:
+        return entry.type;
+    case RxTxRole:
+        return entry.service->isRxTx();
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> ServiceListModel::roleNames() const
+{
+    return {{NameRole, "serviceName"},
+            {UuidRole, "serviceUuid"},
+            {TypeRole, "serviceType"},
+            {RxTxRole, "isRxTx"}};
+}
+
+void ServiceListModel::append(ServiceInfo *service)
+{
+    const int row = int(m_entries.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.append({service, service->getName(), service->getUuid(), service->getType()});
+    endInsertRows();
+    emit countChanged();
+}
+
+void ServiceListModel::clear()
+{
+    if (m_entries.isEmpty())
+        return;
+
+    beginRemoveRows(QModelIndex(), 0, int(m_entries.size() - 1));
+    for (const Entry &entry : std::as_const(m_entries))
+        delete entry.service;
+    m_entries.clear();
+    endRemoveRows();
+    emit countChanged();
+}
+
+ServiceInfo *ServiceListModel::first() const
+{
+    return m_entries.isEmpty() ? nullptr : m_entries.first().service;
+}
+
+ServiceInfo *ServiceListModel::find(const QString &uuid) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.uuid == uuid)
+            return entry.service;
+    }
+    return nullptr;
+}
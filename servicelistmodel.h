@@ -0,0 +1,51 @@
+#ifndef SERVICELISTMODEL_H
+#define SERVICELISTMODEL_H
+
+#include "serviceinfo.h"
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include <QQmlEngine>
+
+// Services of the connected device, owns the ServiceInfo objects. Role data
+// is formatted once when a service is added.
+class ServiceListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+    QML_ANONYMOUS
+
+public:
+    enum Roles { NameRole = Qt::UserRole + 1, UuidRole, TypeRole, RxTxRole };
+
+    explicit ServiceListModel(QObject *parent = nullptr);
+    ~ServiceListModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void append(ServiceInfo *service);
+    void clear();
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    ServiceInfo *first() const;
+    ServiceInfo *find(const QString &uuid) const;
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry
+    {
+        ServiceInfo *service;
+        QString name;
+        QString uuid;
+        QString type;
+    };
+
+    QList<Entry> m_entries;
+};
+
+#endif // SERVICELISTMODEL_H
@@ -0,0 +1,76 @@
+#ifndef SETTINGSSLOT_H
+#define SETTINGSSLOT_H
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+// One setting (a curve table, mixer matrix, filter) that the frame clock
+// reads while the GUI thread replaces it. Presets are static and only
+// pointed at; custom values are copied into one of two buffers owned by the
+// slot. The reader announces the buffer it uses in a hazard pointer, and the
+// writer waits for the reader to let go of the spare buffer before
+// overwriting it. Replacing a value never allocates and nothing outlives the
+// slot.
+//
+// One writer thread and one reader thread at a time.
+template<typename T>
+class SettingsSlot
+{
+public:
+    // writer side. nullptr turns the setting off.
+    void setPreset(const T *preset)
+    {
+        m_current.store(preset, std::memory_order_seq_cst);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    void setCustom(const T &value)
+    {
+        T *spare = &m_buffers[m_current.load(std::memory_order_relaxed) == &m_buffers[0] ? 1 : 0];
+        // the reader only holds a value for the length of one frame
+        while (m_hazard.load(std::memory_order_seq_cst) == spare)
+            std::this_thread::yield();
+
+        *spare = value;
+        m_current.store(spare, std::memory_order_seq_cst);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // what the writer last set, not safe to dereference on the writer side
+    const T *current() const { return m_current.load(std::memory_order_relaxed); }
+    bool isCustom() const
+    {
+        const T *value = current();
+        return value == &m_buffers[0] || value == &m_buffers[1];
+    }
+
+    // reader side, the value stays valid until release()
+    const T *acquire()
+    {
+        const T *value = m_current.load(std::memory_order_acquire);
+        for (;;) {
+            m_hazard.store(value, std::memory_order_seq_cst);
+            const T *again = m_current.load(std::memory_order_seq_cst);
+            if (again == value)
+                return value;
+            value = again;
+        }
+    }
+
+    void release() { m_hazard.store(nullptr, std::memory_order_release); }
+
+    // changes with every set, tells the reader to restart state derived from
+    // the value
+    quint32 generation() const { return m_generation.load(std::memory_order_acquire); }
+
+private:
+    std::array<T, 2> m_buffers{};
+    std::atomic<const T *> m_current{nullptr};
+    std::atomic<const T *> m_hazard{nullptr};
+    std::atomic<quint32> m_generation{0};
+};
+
+#endif // SETTINGSSLOT_H
@@ -0,0 +1,65 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+// Lock-free byte ring for exactly one producer and one consumer thread.
+// Capacity must be a power of two.
+template<qsizetype Capacity>
+class SpscByteRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // all or nothing, false if there is not enough room
+    bool push(const char *data, qsizetype size)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        const quint64 tail = m_tail.load(std::memory_order_acquire);
+        if (size > Capacity - qsizetype(head - tail))
+            return false;
+
+        const qsizetype offset = qsizetype(head & (Capacity - 1));
+        const qsizetype first = qMin(size, Capacity - offset);
+        std::copy_n(data, first, m_buffer.data() + offset);
+        std::copy_n(data + first, size - first, m_buffer.data());
+        m_head.store(head + size, std::memory_order_release);
+        return true;
+    }
+
+    // up to maxSize bytes, returns how many were copied
+    qsizetype pop(char *out, qsizetype maxSize)
+    {
+        const quint64 tail = m_tail.load(std::memory_order_relaxed);
+        const quint64 head = m_head.load(std::memory_order_acquire);
+        const qsizetype size = qMin(maxSize, qsizetype(head - tail));
+        if (size <= 0)
+            return 0;
+
+        const qsizetype offset = qsizetype(tail & (Capacity - 1));
+        const qsizetype first = qMin(size, Capacity - offset);
+        std::copy_n(m_buffer.data() + offset, first, out);
+        std::copy_n(m_buffer.data(), size - first, out + first);
+        m_tail.store(tail + size, std::memory_order_release);
+        return size;
+    }
+
+    qsizetype size() const
+    {
+        return qsizetype(m_head.load(std::memory_order_acquire)
+                         - m_tail.load(std::memory_order_acquire));
+    }
+
+    static constexpr qsizetype capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<quint64> m_head{0};
+    alignas(64) std::atomic<quint64> m_tail{0};
+    std::array<char, Capacity> m_buffer;
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,197 @@
+#include "telemetrypipeline.h"
+
+#include <controlprotocol.h>
+#include <eventtrace.h>
+
+#include <QThread>
+#include <QTimer>
+
+#include <cstring>
+
+using namespace Qt::StringLiterals;
+
+namespace {
+// what the eye can follow, telemetry may arrive a lot faster
+constexpr int default_publish_interval = 66;
+
+inline int getU16(const char *in)
+{
+    return quint8(in[0]) | (quint8(in[1]) << 8);
+}
+
+inline int getS16(const char *in)
+{
+    return qint16(quint16(getU16(in)));
+}
+} // namespace
+
+TelemetryPipeline::TelemetryPipeline(QObject *parent)
+    : QObject{parent}
+{
+    m_publish_timer = new QTimer(this);
+    m_publish_timer->setInterval(default_publish_interval);
+    connect(m_publish_timer, &QTimer::timeout, this, &TelemetryPipeline::publish);
+    m_publish_timer->start();
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName(u"TelemetryRx"_s);
+    m_thread->start(QThread::LowPriority);
+}
+
+TelemetryPipeline::~TelemetryPipeline()
+{
+    m_stop = true;
+    m_pending.release();
+    m_thread->wait();
+    delete m_thread;
+}
+
+void TelemetryPipeline::setPublishInterval(int msec)
+{
+    m_publish_timer->setInterval(qMax(msec, 1));
+}
+
+void TelemetryPipeline::push(const QByteArray &notification)
+{
+    if (!m_ring.push(notification.constData(), notification.size())) {
+        m_overflow_bytes += notification.size();
+        return;
+    }
+    m_pending.release();
+}
+
+void TelemetryPipeline::run()
+{
+    while (!m_stop) {
+        m_pending.acquire();
+        // one pass handles everything pushed so far
+        m_pending.tryAcquire(m_pending.available());
+        drain();
+    }
+}
+
+void TelemetryPipeline::drain()
+{
+    EVENT_TRACE_SCOPE("rx", "telemetryDrain");
+    for (;;) {
+        const qsizetype read = m_ring.pop(m_assembly + m_fill, assembly_size - m_fill);
+        m_fill += read;
+
+        qsizetype offset = 0;
+        while (offset < m_fill) {
+            const char *frame = m_assembly + offset;
+            const qsizetype left = m_fill - offset;
+            if (quint8(frame[0]) != ControlProtocol::sync_byte) {
+                ++offset;
+                continue;
+            }
+
+            const int size = ControlProtocol::frameSize(frame, left);
+            if (size < 0) {
+                ++offset;
+                continue;
+            }
+            if (size == 0 || size > left)
+                break;
+
+            // a corrupted frame may have swallowed the start of the next one
+            offset += processFrame(frame, size) ? size : 1;
+        }
+
+        if (offset == 0 && m_fill == assembly_size) {
+            // nothing parseable in a full buffer, resync from scratch
+            m_fill = 0;
+        } else if (offset > 0) {
+            m_fill -= offset;
+            std::memmove(m_assembly, m_assembly + offset, size_t(m_fill));
+        }
+
+        if (!read)
+            return;
+    }
+}
+
+bool TelemetryPipeline::processFrame(const char *data, int size)
+{
+    if (!ControlProtocol::checkCrc(data, size)) {
+        ++m_crc_errors;
+        return false;
+    }
+    ++m_frames;
+
+    ControlProtocol::ChannelFrame header;
+    switch (ControlProtocol::FrameType(ControlProtocol::peekType(data, size))) {
+    case ControlProtocol::FrameType::Ack:
+        if (ControlProtocol::decode(data, size, header))
+            emit keyframeAcknowledged(header.sequence);
+        break;
+    case ControlProtocol::FrameType::Ping:
+    case ControlProtocol::FrameType::Pong:
+        // a loopback peripheral echoes the Ping itself
+        if (ControlProtocol::decode(data, size, header))
+            emit pongReceived(header.sequence, header.timestamp);
+        break;
+    case ControlProtocol::FrameType::Telemetry: {
+        const char *payload = nullptr;
+        int payloadSize = 0;
+        if (ControlProtocol::decodeTelemetry(data, size, header, payload, payloadSize))
+            decodeRecords(payload, payloadSize);
+        break;
+    }
+    default:
+        // e.g. our own control frames echoed back by a loopback peripheral
+        break;
+    }
+    return true;
+}
+
+void TelemetryPipeline::decodeRecords(const char *data, int size)
+{
+    using ControlProtocol::TelemetryRecord;
+
+    int offset = 0;
+    while (offset < size) {
+        const quint8 record = quint8(data[offset]);
+        const int length = ControlProtocol::telemetryRecordSize(record);
+        if (length < 0 || offset + 1 + length > size)
+            break;
+
+        const char *body = data + offset + 1;
+        switch (TelemetryRecord(record)) {
+        case TelemetryRecord::Battery:
+            m_millivolts.store(getU16(body), std::memory_order_relaxed);
+            m_centiamps.store(getS16(body + 2), std::memory_order_relaxed);
+            m_remaining.store(quint8(body[4]), std::memory_order_relaxed);
+            break;
+        case TelemetryRecord::Attitude:
+            m_roll.store(getS16(body), std::memory_order_relaxed);
+            m_pitch.store(getS16(body + 2), std::memory_order_relaxed);
+            m_yaw.store(getS16(body + 4), std::memory_order_relaxed);
+            break;
+        case TelemetryRecord::LinkStats:
+            m_rssi.store(qint8(body[0]), std::memory_order_relaxed);
+            m_link_quality.store(quint8(body[1]), std::memory_order_relaxed);
+            break;
+        }
+        offset += 1 + length;
+    }
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+
+void TelemetryPipeline::publish()
+{
+    const quint64 generation = m_generation.load(std::memory_order_acquire);
+    if (generation == m_published.generation)
+        return;
+
+    m_published.millivolts = m_millivolts.load(std::memory_order_relaxed);
+    m_published.centiamps = m_centiamps.load(std::memory_order_relaxed);
+    m_published.remaining = m_remaining.load(std::memory_order_relaxed);
+    m_published.roll = m_roll.load(std::memory_order_relaxed);
+    m_published.pitch = m_pitch.load(std::memory_order_relaxed);
+    m_published.yaw = m_yaw.load(std::memory_order_relaxed);
+    m_published.rssi = m_rssi.load(std::memory_order_relaxed);
+    m_published.linkQuality = m_link_quality.load(std::memory_order_relaxed);
+    m_published.generation = generation;
+    emit telemetryChanged();
+}
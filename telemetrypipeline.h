@@ -0,0 +1,114 @@
+#ifndef TELEMETRYPIPELINE_H
+#define TELEMETRYPIPELINE_H
+
+#include <QObject>
+#include <QSemaphore>
+
+#include <spscring.h>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+class QTimer;
+QT_END_NAMESPACE
+
+// Receive side of the link. Notifications are copied into a lock-free ring
+// on the thread they arrive on, a worker thread reassembles frames that span
+// notifications and decodes them, and the latest telemetry values are
+// published to QML at display rate only.
+class TelemetryPipeline : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool available READ available NOTIFY telemetryChanged)
+    Q_PROPERTY(double batteryVoltage READ batteryVoltage NOTIFY telemetryChanged)
+    Q_PROPERTY(double batteryCurrent READ batteryCurrent NOTIFY telemetryChanged)
+    Q_PROPERTY(int batteryRemaining READ batteryRemaining NOTIFY telemetryChanged)
+    Q_PROPERTY(double roll READ roll NOTIFY telemetryChanged)
+    Q_PROPERTY(double pitch READ pitch NOTIFY telemetryChanged)
+    Q_PROPERTY(double yaw READ yaw NOTIFY telemetryChanged)
+    Q_PROPERTY(int rssi READ rssi NOTIFY telemetryChanged)
+    Q_PROPERTY(int linkQuality READ linkQuality NOTIFY telemetryChanged)
+
+public:
+    explicit TelemetryPipeline(QObject *parent = nullptr);
+    ~TelemetryPipeline();
+
+    bool available() const { return m_published.generation != 0; }
+    double batteryVoltage() const { return m_published.millivolts / 1000.0; }
+    double batteryCurrent() const { return m_published.centiamps / 100.0; }
+    int batteryRemaining() const { return m_published.remaining; }
+    double roll() const { return m_published.roll / 100.0; }
+    double pitch() const { return m_published.pitch / 100.0; }
+    double yaw() const { return m_published.yaw / 100.0; }
+    int rssi() const { return m_published.rssi; }
+    int linkQuality() const { return m_published.linkQuality; }
+
+    void setPublishInterval(int msec);
+
+    Q_INVOKABLE quint64 framesDecoded() const { return m_frames; }
+    Q_INVOKABLE quint64 crcErrors() const { return m_crc_errors; }
+    // bytes lost because the worker fell behind and the ring was full
+    Q_INVOKABLE quint64 overflowBytes() const { return m_overflow_bytes; }
+
+public slots:
+    // copies the notification, never blocks
+    void push(const QByteArray &notification);
+
+signals:
+    void telemetryChanged();
+    // emitted on the worker thread
+    void keyframeAcknowledged(quint16 sequence);
+    void pongReceived(quint16 sequence, quint32 timestamp);
+
+private:
+    struct Values
+    {
+        int millivolts = 0;
+        int centiamps = 0;
+        int remaining = 0;
+        int roll = 0;
+        int pitch = 0;
+        int yaw = 0;
+        int rssi = 0;
+        int linkQuality = 0;
+        quint64 generation = 0;
+    };
+
+    void run();
+    void drain();
+    bool processFrame(const char *data, int size);
+    void decodeRecords(const char *data, int size);
+    void publish();
+
+    static constexpr qsizetype assembly_size = 1024;
+
+    QThread *m_thread = nullptr;
+    QTimer *m_publish_timer = nullptr;
+    QSemaphore m_pending;
+    std::atomic<bool> m_stop{false};
+    SpscByteRing<16384> m_ring;
+
+    // worker thread only
+    char m_assembly[assembly_size];
+    qsizetype m_fill = 0;
+
+    std::atomic<int> m_millivolts{0};
+    std::atomic<int> m_centiamps{0};
+    std::atomic<int> m_remaining{0};
+    std::atomic<int> m_roll{0};
+    std::atomic<int> m_pitch{0};
+    std::atomic<int> m_yaw{0};
+    std::atomic<int> m_rssi{0};
+    std::atomic<int> m_link_quality{0};
+    std::atomic<quint64> m_generation{0};
+
+    std::atomic<quint64> m_frames{0};
+    std::atomic<quint64> m_crc_errors{0};
+    std::atomic<quint64> m_overflow_bytes{0};
+
+    // GUI thread only
+    Values m_published;
+};
+
+#endif // TELEMETRYPIPELINE_H
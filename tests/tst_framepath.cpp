@@ -0,0 +1,162 @@
+#include <QLowEnergyCharacteristic>
+#include <QSemaphore>
+#include <QTest>
+#include <QtEndian>
+
+#include <benchmark.h>
+#include <blelinktransport.h>
+#include <controllerobject.h>
+#include <controlprotocol.h>
+#include <loopbacklinktransport.h>
+#include <writequeue.h>
+
+#include <cmath>
+#include <thread>
+
+// Heap allocations on the per frame path, from the stick slots through the
+// encoder into a transport's WriteQueue and out to the radio. Counted with
+// the operator new replacement of the benchmarks, once the path is warm.
+class TestFramePath : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeQueue();
+    void loopback_data();
+    void loopback();
+    void bleFlush();
+};
+
+namespace {
+constexpr int warmup_frames = 1000;
+constexpr int measured_frames = 5000;
+
+// receiver side of PackedV1, acknowledges every keyframe right away
+void acknowledgeKeyframes(ControllerObject &controller, const QByteArray &frame)
+{
+    if (ControlProtocol::peekType(frame.constData(), frame.size())
+        == quint8(ControlProtocol::FrameType::PackedKeyframe))
+        controller.acknowledgeKeyframe(qFromLittleEndian<quint16>(frame.constData() + 2));
+}
+} // namespace
+
+void TestFramePath::writeQueue()
+{
+    WriteQueue queue;
+    QList<WriteQueue::Entry> out;
+    out.reserve(4);
+    const QByteArray frame(20, 'x');
+    const QByteArray message(8, 'm');
+
+    auto step = [&]() {
+        queue.push(frame, WriteQueue::ControlFrame, 1);
+        queue.push(frame, WriteQueue::ControlFrame, 2);
+        queue.push(message, WriteQueue::Message, 3);
+        queue.take(4, out);
+        out.clear();
+    };
+    for (int i = 0; i < warmup_frames; ++i)
+        step();
+
+    const quint64 before = Benchmark::allocations();
+    for (int i = 0; i < measured_frames; ++i)
+        step();
+    QCOMPARE(Benchmark::allocations() - before, 0ull);
+}
+
+void TestFramePath::loopback_data()
+{
+    QTest::addColumn<ControllerObject::FrameFormat>("format");
+    QTest::newRow("raw") << ControllerObject::RawFormat;
+    QTest::newRow("protocol_v1") << ControllerObject::ProtocolV1;
+    QTest::newRow("packed_v1") << ControllerObject::PackedV1;
+}
+
+void TestFramePath::loopback()
+{
+    QFETCH(ControllerObject::FrameFormat, format);
+
+    // frames are built by hand below
+    ControllerObject controller(nullptr, nullptr);
+    controller.setFrameFormat(format);
+    controller.setChannelCount(8);
+
+    LoopbackLinkTransport transport;
+    transport.setMtu(247);
+    transport.setEcho(false);
+    transport.open();
+    controller.setMaxFrameSize(transport.mtu() - 3);
+
+    QObject::connect(&controller,
+                     &ControllerObject::dataUpdated,
+                     &transport,
+                     [&](const QByteArray &data) { transport.write(data); },
+                     Qt::DirectConnection);
+    QObject::connect(&transport,
+                     &LoopbackLinkTransport::peripheralReceived,
+                     &controller,
+                     [&](const QByteArray &data) { acknowledgeKeyframes(controller, data); },
+                     Qt::DirectConnection);
+
+    auto step = [&](int i) {
+        const double phase = i * 0.01;
+        controller.leftStickMoved(std::sin(phase), std::cos(phase));
+        controller.rightStickMoved(std::cos(phase), std::sin(phase));
+        controller.sendFrame();
+        transport.connectionEvent();
+    };
+    for (int i = 0; i < warmup_frames; ++i)
+        step(i);
+
+    const quint64 written = transport.writtenPackets();
+    const quint64 before = Benchmark::allocations();
+    const quint64 ring_before = controller.frameAllocations();
+    for (int i = 0; i < measured_frames; ++i)
+        step(warmup_frames + i);
+    const quint64 allocations = Benchmark::allocations() - before;
+
+    QCOMPARE(transport.writtenPackets() - written, quint64(measured_frames));
+    QCOMPARE(transport.rejectedPackets(), 0ull);
+    QCOMPARE(transport.radioLatency().count(), transport.writtenPackets());
+    QCOMPARE(controller.frameAllocations() - ring_before, 0ull);
+    QCOMPARE(allocations, 0ull);
+}
+
+void TestFramePath::bleFlush()
+{
+    // not connected, so the radio write itself is skipped, but writes from
+    // another thread queue and post their flush like on a live link
+    BleLinkTransport transport(nullptr, nullptr, {}, {});
+    const QByteArray frame(20, 'x');
+
+    QSemaphore go;
+    QSemaphore written;
+    const int frames = warmup_frames + measured_frames;
+    // stands in for the frame clock thread
+    std::thread clock([&]() {
+        for (int i = 0; i < frames; ++i) {
+            go.acquire();
+            transport.write(frame);
+            written.release();
+        }
+    });
+
+    auto step = [&]() {
+        go.release();
+        written.acquire();
+        QCoreApplication::sendPostedEvents();
+    };
+    for (int i = 0; i < warmup_frames; ++i)
+        step();
+
+    const quint64 before = Benchmark::allocations();
+    for (int i = 0; i < measured_frames; ++i)
+        step();
+    const quint64 allocations = Benchmark::allocations() - before;
+    clock.join();
+
+    QCOMPARE(allocations, 0ull);
+}
+
+QTEST_GUILESS_MAIN(TestFramePath)
+#include "tst_framepath.moc"
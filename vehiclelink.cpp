@@ -0,0 +1,214 @@
+#include "vehiclelink.h"
+
+#include <blelinktransport.h>
+#include <controllerobject.h>
+#include <linktransport.h>
+
+VehicleLink::VehicleLink(const QString &name,
+                         LinkTransport *transport,
+                         FrameScheduler *clock,
+                         QObject *parent)
+    : QObject{parent}
+    , m_name(name)
+    , m_transport(transport)
+{
+    m_controller = new ControllerObject(clock, this);
+
+    // a BLE transport stays on the Bluetooth thread, the destructor frees it
+    if (m_transport->thread() == thread())
+        m_transport->setParent(this);
+    watchTransport();
+    connect(m_transport, &LinkTransport::mtuChanged, this, [this]() {
+        m_controller->setMaxFrameSize(m_transport->mtu() - 3);
+    });
+    m_controller->setMaxFrameSize(m_transport->mtu() - 3);
+    if (auto ble = qobject_cast<BleLinkTransport *>(m_transport)) {
+        connect(ble, &BleLinkTransport::linkIntervalChanged, this, [this, ble]() {
+            setLinkInterval(ble->linkInterval());
+        });
+        setLinkInterval(ble->linkInterval());
+    }
+
+    // runs on the clock thread
+    connect(
+        m_controller,
+        &ControllerObject::dataUpdated,
+        this,
+        [this](const QByteArray &data) { m_transport->write(data); },
+        Qt::DirectConnection);
+}
+
+VehicleLink::VehicleLink(const QString &name, ControllerObject *controller, QObject *parent)
+    : QObject{parent}
+    , m_name(name)
+    , m_controller(controller)
+    , m_primary(true)
+{}
+
+VehicleLink::~VehicleLink()
+{
+    if (!m_primary && m_transport->parent() != this)
+        m_transport->deleteLater();
+}
+
+void VehicleLink::watchTransport()
+{
+    m_ready = m_transport && m_transport->isReady();
+    if (!m_transport)
+        return;
+
+    connect(m_transport, &LinkTransport::readyChanged, this, [this]() {
+        m_ready = m_transport->isReady();
+        // Device resets the encoder of the primary vehicle
+        if (m_ready && !m_primary) {
+            m_controller->resetEncoder();
+            m_controller->markChanged();
+        }
+        emit readyChanged();
+    });
+}
+
+QString VehicleLink::name() const
+{
+    return m_name;
+}
+
+ControllerObject *VehicleLink::controller() const
+{
+    return m_controller;
+}
+
+LinkTransport *VehicleLink::transport() const
+{
+    return m_transport;
+}
+
+void VehicleLink::setTransport(LinkTransport *transport)
+{
+    Q_ASSERT(m_primary);
+    if (m_transport == transport)
+        return;
+
+    if (m_transport)
+        m_transport->disconnect(this);
+    m_transport = transport;
+    watchTransport();
+    emit readyChanged();
+}
+
+bool VehicleLink::isPrimary() const
+{
+    return m_primary;
+}
+
+bool VehicleLink::isReady() const
+{
+    return m_ready;
+}
+
+int VehicleLink::linkInterval() const
+{
+    return m_link_interval;
+}
+
+void VehicleLink::setLinkInterval(int usec)
+{
+    usec = qMax(usec, 0);
+    if (m_link_interval.exchange(usec) == usec)
+        return;
+
+    emit linkIntervalChanged();
+}
+
+quint64 VehicleLink::framesSent() const
+{
+    return m_frames;
+}
+
+double VehicleLink::frameRate() const
+{
+    return m_frame_rate;
+}
+
+double VehicleLink::intervalP50() const
+{
+    return m_intervals.percentile(50) / 1000.0;
+}
+
+double VehicleLink::intervalP99() const
+{
+    return m_intervals.percentile(99) / 1000.0;
+}
+
+double VehicleLink::intervalMax() const
+{
+    return m_intervals.max() / 1000.0;
+}
+
+const LatencyHistogram &VehicleLink::intervals() const
+{
+    return m_intervals;
+}
+
+double VehicleLink::radioLatencyP50() const
+{
+    return radioLatencyPercentile(50);
+}
+
+double VehicleLink::radioLatencyP99() const
+{
+    return radioLatencyPercentile(99);
+}
+
+double VehicleLink::radioLatencyMax() const
+{
+    return m_transport ? m_transport->radioLatency().max() / 1000.0 : 0.0;
+}
+
+double VehicleLink::radioLatencyPercentile(double percent) const
+{
+    return m_transport ? m_transport->radioLatency().percentile(percent) / 1000.0 : 0.0;
+}
+
+void VehicleLink::resetStatistics()
+{
+    m_intervals.reset();
+    if (m_transport)
+        m_transport->resetRadioLatency();
+    emit statisticsChanged();
+}
+
+bool VehicleLink::isFrameDue(qint64 nowUs, qint64 heartbeatUs) const
+{
+    if (m_last_frame_us == 0)
+        return true;
+
+    const qint64 elapsed = nowUs - m_last_frame_us;
+    if (elapsed < m_link_interval)
+        return false;
+    // the shared clock ticks at least once per heartbeat interval, half of it
+    // keeps every link within one and a half while others are busy
+    return m_controller->hasChanged() || elapsed >= heartbeatUs / 2;
+}
+
+bool VehicleLink::hasPendingChange() const
+{
+    return m_controller->hasChanged();
+}
+
+void VehicleLink::sendFrame(qint64 nowUs)
+{
+    if (m_last_frame_us != 0)
+        m_intervals.record(nowUs - m_last_frame_us);
+    m_last_frame_us = nowUs;
+    ++m_frames;
+    m_controller->sendFrame();
+}
+
+void VehicleLink::updateStatistics(qint64 elapsedMs)
+{
+    const quint64 frames = m_frames;
+    m_frame_rate = elapsedMs > 0 ? (frames - m_frames_at_update) * 1000.0 / elapsedMs : 0.0;
+    m_frames_at_update = frames;
+    emit statisticsChanged();
+}
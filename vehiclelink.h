@@ -0,0 +1,107 @@
+#ifndef VEHICLELINK_H
+#define VEHICLELINK_H
+
+#include <QObject>
+#include <QString>
+
+#include <latencyhistogram.h>
+
+#include <atomic>
+
+class ControllerObject;
+class FrameScheduler;
+class LinkTransport;
+
+// One vehicle of a multi-vehicle session: its own channel state and encoder
+// (a ControllerObject) and its own link. Frames are clocked by LinkScheduler.
+//
+// Device's primary vehicle is a link too, but its controller and transport
+// stay with Device, which routes the frames and reconnects. Such a link only
+// clocks the controller and reports on the transport set with setTransport().
+class VehicleLink : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString name READ name CONSTANT)
+    Q_PROPERTY(ControllerObject *controller READ controller CONSTANT)
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+    Q_PROPERTY(quint64 framesSent READ framesSent NOTIFY statisticsChanged)
+    // frames per second over the last statistics period
+    Q_PROPERTY(double frameRate READ frameRate NOTIFY statisticsChanged)
+    // time between two frames of this link, milliseconds
+    Q_PROPERTY(double intervalP50 READ intervalP50 NOTIFY statisticsChanged)
+    Q_PROPERTY(double intervalP99 READ intervalP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(double intervalMax READ intervalMax NOTIFY statisticsChanged)
+    // from the transport write until the radio took the frame, milliseconds
+    Q_PROPERTY(double radioLatencyP50 READ radioLatencyP50 NOTIFY statisticsChanged)
+    Q_PROPERTY(double radioLatencyP99 READ radioLatencyP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(double radioLatencyMax READ radioLatencyMax NOTIFY statisticsChanged)
+    Q_PROPERTY(bool primary READ isPrimary CONSTANT)
+    // connection interval of this vehicle, microseconds, 0 if unknown
+    Q_PROPERTY(int linkInterval READ linkInterval NOTIFY linkIntervalChanged)
+
+public:
+    // takes ownership of the transport, the controller is driven by clock
+    VehicleLink(const QString &name,
+                LinkTransport *transport,
+                FrameScheduler *clock,
+                QObject *parent = nullptr);
+    // primary vehicle, owns neither the controller nor a transport
+    VehicleLink(const QString &name, ControllerObject *controller, QObject *parent = nullptr);
+    ~VehicleLink();
+
+    QString name() const;
+    ControllerObject *controller() const;
+    LinkTransport *transport() const;
+    // primary vehicle only, the transport Device currently writes to
+    void setTransport(LinkTransport *transport);
+    bool isPrimary() const;
+    // safe to call from the clock thread
+    bool isReady() const;
+    int linkInterval() const;
+    void setLinkInterval(int usec);
+
+    quint64 framesSent() const;
+    double frameRate() const;
+    double intervalP50() const;
+    double intervalP99() const;
+    double intervalMax() const;
+    const LatencyHistogram &intervals() const;
+    double radioLatencyP50() const;
+    double radioLatencyP99() const;
+    double radioLatencyMax() const;
+    Q_INVOKABLE void resetStatistics();
+
+    // called by LinkScheduler on its clock thread. In OnChange mode a frame
+    // is due when the input changed, no sooner than one link interval after
+    // the last one, or for a heartbeat.
+    bool isFrameDue(qint64 nowUs, qint64 heartbeatUs) const;
+    bool hasPendingChange() const;
+    void sendFrame(qint64 nowUs);
+    // the link was skipped because it is not ready, its outage is not an interval
+    void markIdle() { m_last_frame_us = 0; }
+    // called by LinkScheduler on the GUI thread
+    void updateStatistics(qint64 elapsedMs);
+
+signals:
+    void readyChanged();
+    void statisticsChanged();
+    void linkIntervalChanged();
+
+private:
+    void watchTransport();
+    double radioLatencyPercentile(double percent) const;
+
+    QString m_name;
+    ControllerObject *m_controller = nullptr;
+    LinkTransport *m_transport = nullptr;
+    bool m_primary = false;
+    std::atomic<bool> m_ready{false};
+    std::atomic<int> m_link_interval{0};
+    LatencyHistogram m_intervals;
+    qint64 m_last_frame_us = 0;
+    std::atomic<quint64> m_frames{0};
+    quint64 m_frames_at_update = 0;
+    double m_frame_rate = 0;
+};
+
+#endif // VEHICLELINK_H
@@ -0,0 +1,79 @@
+#include "writequeue.h"
+
+#include <chrono>
+
+WriteQueue::WriteQueue(int maxMessages)
+    : m_max_messages(qMax(maxMessages, 1))
+{
+    m_messages.reserve(m_max_messages);
+}
+
+bool WriteQueue::push(const QByteArray &data, Kind kind, quint32 traceId)
+{
+    const qint64 queued = now();
+    QMutexLocker locker(&m_mutex);
+    bool kept = true;
+    if (kind == ControlFrame) {
+        if (m_has_control)
+            ++m_stale_dropped;
+        m_control = {data, traceId, queued};
+        m_has_control = true;
+    } else {
+        if (m_messages.size() >= m_max_messages) {
+            m_messages.removeFirst();
+            ++m_messages_dropped;
+            kept = false;
+        }
+        m_messages.append({data, traceId, queued});
+    }
+    updateDepth();
+    return kept;
+}
+
+int WriteQueue::take(int count, QList<Entry> &out)
+{
+    QMutexLocker locker(&m_mutex);
+    int taken = 0;
+    if (m_has_control && taken < count) {
+        out.append(std::move(m_control));
+        m_control = {};
+        m_has_control = false;
+        ++taken;
+    }
+    while (taken < count && !m_messages.isEmpty()) {
+        out.append(m_messages.takeFirst());
+        ++taken;
+    }
+    updateDepth();
+    return taken;
+}
+
+void WriteQueue::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_control = {};
+    m_has_control = false;
+    m_messages.clear();
+    updateDepth();
+}
+
+void WriteQueue::resetCounters()
+{
+    m_max_depth = m_depth.load();
+    m_stale_dropped = 0;
+    m_messages_dropped = 0;
+}
+
+qint64 WriteQueue::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void WriteQueue::updateDepth()
+{
+    const int depth = int(m_messages.size()) + (m_has_control ? 1 : 0);
+    m_depth = depth;
+    if (depth > m_max_depth)
+        m_max_depth = depth;
+}
@@ -0,0 +1,58 @@
+#ifndef WRITEQUEUE_H
+#define WRITEQUEUE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+
+#include <atomic>
+
+// Outgoing packets of a link waiting for the radio to accept them. Control
+// frames are latest wins, a newer frame replaces one that is still pending,
+// so a congested link sends fresh stick values instead of a backlog.
+// Messages (pings and the like) are kept in order up to a fixed depth.
+class WriteQueue
+{
+public:
+    enum Kind { ControlFrame, Message };
+
+    struct Entry
+    {
+        QByteArray data;
+        quint32 traceId = 0;
+        // now() when the packet was pushed
+        qint64 queuedNs = 0;
+    };
+
+    explicit WriteQueue(int maxMessages = 8);
+
+    // thread safe, returns false if the oldest message had to be dropped
+    bool push(const QByteArray &data, Kind kind, quint32 traceId);
+    // appends up to count entries to out, the control frame goes first
+    int take(int count, QList<Entry> &out);
+    void clear();
+
+    int depth() const { return m_depth; }
+    int maxDepth() const { return m_max_depth; }
+    quint64 staleFramesDropped() const { return m_stale_dropped; }
+    quint64 messagesDropped() const { return m_messages_dropped; }
+    void resetCounters();
+
+    // steady clock in nanoseconds, what queuedNs is stamped with
+    static qint64 now();
+
+private:
+    void updateDepth();
+
+    QMutex m_mutex;
+    Entry m_control;
+    bool m_has_control = false;
+    QList<Entry> m_messages;
+    int m_max_messages;
+    std::atomic<int> m_depth{0};
+    std::atomic<int> m_max_depth{0};
+    std::atomic<quint64> m_stale_dropped{0};
+    std::atomic<quint64> m_messages_dropped{0};
+};
+
+#endif // WRITEQUEUE_H